@@ -7,7 +7,7 @@ class VBO {
     public:
         GLuint ID;
 
-        VBO(GLfloat* vertices, GLsizeiptr size);
+        VBO(const void* vertices, GLsizeiptr size);
 
         void bind();
         void unbind();
@@ -0,0 +1,8 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+// headless benchmarks, run with ./MinecraftClone --bench
+// no window or GL context is created
+int run_benchmarks();
+
+#endif
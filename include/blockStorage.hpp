@@ -0,0 +1,46 @@
+#ifndef BLOCK_STORAGE_HPP
+#define BLOCK_STORAGE_HPP
+
+#include <vector>
+#include <cstdint>
+#include "block.hpp"
+
+static_assert(BLOCK_COUNT <= 256, "palette indices are at most 8 bits");
+
+// block ids of a chunk as indices into a palette of the ids it contains,
+// bit packed at 1, 2, 4 or 8 bits per block depending on the palette size.
+// indices never straddle a 64 bit word, so a lookup is one shift and mask
+class BlockStorage {
+public:
+    BlockStorage(int size); // all air
+
+    BlockID get(int index) const {
+        uint64_t word = words[index >> (6 - bitsLog2)];
+        int offset = (index & ((64 >> bitsLog2) - 1)) << bitsLog2;
+        return palette[(word >> offset) & mask];
+    }
+    void set(int index, BlockID id);
+    // replaces every block, ids holds size() entries
+    void assign(const BlockID* ids);
+
+    // palette index of every block at once, out holds size() entries
+    void unpack(uint8_t* out) const;
+    const std::vector<BlockID>& get_palette() const { return palette; }
+
+    int size() const { return count; }
+    int bits_per_block() const { return 1 << bitsLog2; }
+    size_t memory_bytes() const;
+
+private:
+    int count;
+    int bitsLog2 = 0;  // 1 bit per block to start with
+    uint64_t mask = 1;
+    std::vector<BlockID> palette; // entries stay once added, edits don't shrink it
+    std::vector<uint64_t> words;
+
+    int palette_index(BlockID id) const;
+    void write(int index, uint64_t entry);
+    void grow();
+};
+
+#endif
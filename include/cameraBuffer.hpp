@@ -0,0 +1,40 @@
+#ifndef CAMERA_BUFFER_HPP
+#define CAMERA_BUFFER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "shaderClass.hpp"
+
+// std140 layout of the Camera uniform block in shaders/camera.glsl,
+// fields and order have to match it
+struct CameraData {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec4 position = glm::vec4(0.0f); // w unused
+    glm::vec4 fogColor = glm::vec4(0.35f, 0.8f, 1.0f, 1.0f);
+    float fogStart = 5.0f; // view distances where the fog starts and covers everything
+    float fogEnd = 64.0f;
+    int underWater = 0;
+    float padding = 0.0f;
+};
+static_assert(sizeof(CameraData) == 176, "CameraData has to match the std140 Camera block");
+
+// per frame camera data in one uniform buffer, bound to a fixed binding
+// point and shared by every shader program, so it's uploaded once a frame
+// instead of as uniforms of each program
+class CameraBuffer {
+public:
+    static const GLuint BINDING = 0;
+
+    CameraBuffer();
+
+    // points the program's Camera block to the buffer, once after linking
+    void attach(Shader& shader);
+    void update(const CameraData& data);
+    void free();
+
+private:
+    GLuint ID = 0;
+};
+
+#endif
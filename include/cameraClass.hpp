@@ -31,6 +31,12 @@ class Camera {
         bool firstMouse;
         bool wireframe;
         bool tabLastFrame;
+        bool greedyMeshing;
+        bool gLastFrame;
+        bool batchedDrawing;
+        bool bLastFrame;
+        bool occlusionCulling;
+        bool oLastFrame;
 
         Camera(float width, float height);
         glm::mat4 get_view_matrix() const;
@@ -39,6 +45,7 @@ class Camera {
         void process_keyboard(GLFWwindow* window, float deltaTime);
         void process_mouse(float xoffset, float yoffset);
         void toggle_polygon();
+        void set_view(const glm::vec3& pos, float newYaw, float newPitch); // scripted camera (flythrough)
 
     private:    
         void update();
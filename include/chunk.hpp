@@ -2,45 +2,172 @@
 #define CHUNK_HPP
 
 #include <vector>
-#include "FastNoiseLite.hpp"
+#include <cstdint>
 #include "block.hpp"
-#include "VAO.hpp"
-#include "VBO.hpp"
-#include "EBO.hpp"
+#include "chunkSection.hpp"
+#include "chunkMesh.hpp"
+#include "chunkRandom.hpp"
+#include "shaderClass.hpp"
+#include "quadIndexBuffer.hpp"
+#include "meshArena.hpp"
 
-const int CHUNK_SIZE = 8;
-const int CHUNK_HEIGHT = 30;
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// chunk width (log2) and height in blocks, picked at build time,
+// e.g. cmake -DCHUNK_SIZE_LOG2=4 for 16 wide chunks
+#ifndef CHUNK_SIZE_LOG2
+#define CHUNK_SIZE_LOG2 3
+#endif
+#ifndef CHUNK_HEIGHT_BLOCKS
+#define CHUNK_HEIGHT_BLOCKS 30
+#endif
+
+// leaves radius around a tree trunk. trees are placed from the 3x3 chunks
+// around a chunk, so a chunk has to be at least this wide
+const int TREE_REACH = 3;
+
+// dimensions of a chunk and its sections. widths are powers of two, so
+// world --> chunk coords and block indices are shifts and masks
+template <int SizeLog2, int Height>
+struct ChunkDimensions {
+    static constexpr int SIZE_LOG2 = SizeLog2;
+    static constexpr int SIZE = 1 << SizeLog2;
+    static constexpr int MASK = SIZE - 1;
+    static constexpr int HEIGHT = Height;
+
+    // chunks are stored and meshed in sections of SECTION_HEIGHT y levels, cubes up to 16 wide,
+    // the top one is cut short when HEIGHT isn't a multiple of it
+    static constexpr int SECTION_LOG2 = SizeLog2 < 4 ? SizeLog2 : 4;
+    static constexpr int SECTION_HEIGHT = 1 << SECTION_LOG2;
+    static constexpr int SECTION_COUNT = (Height + SECTION_HEIGHT - 1) / SECTION_HEIGHT;
+    static constexpr int SECTION_VOLUME = SIZE * SECTION_HEIGHT * SIZE;
+
+    // floor division and modulo, negative world coords included (arithmetic shift)
+    static constexpr int chunk_coord(int world) { return world >> SizeLog2; }
+    static constexpr int local_coord(int world) { return world & MASK; }
+
+    // x, z in chunk coords, y in section coords
+    static constexpr int section_index(int x, int y, int z) {
+        return x | (y << SizeLog2) | (z << (SizeLog2 + SECTION_LOG2));
+    }
+
+    // block corners have to fit in the packed vertex (see chunkMesh.hpp)
+    static_assert(SIZE <= 63 && Height <= 511, "chunk too big for the packed vertex format");
+    static_assert(SIZE >= TREE_REACH, "chunk narrower than a tree, trees would be cut at the chunk borders");
+};
+
+using ChunkDims = ChunkDimensions<CHUNK_SIZE_LOG2, CHUNK_HEIGHT_BLOCKS>;
+
+const int CHUNK_SIZE = ChunkDims::SIZE;
+const int CHUNK_HEIGHT = ChunkDims::HEIGHT;
+const int SECTION_HEIGHT = ChunkDims::SECTION_HEIGHT;
+const int SECTION_COUNT = ChunkDims::SECTION_COUNT;
+const int SECTION_VOLUME = ChunkDims::SECTION_VOLUME;
+
+// one bit per y level of a section column, set when the block is solid
+typedef uint64_t ColumnMask;
+static_assert(SECTION_HEIGHT + 2 <= 64, "a section column and its border have to fit in a ColumnMask");
+
+inline int lowest_bit(ColumnMask mask) {
+    // index of the lowest set bit, mask can't be 0
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return int(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// pipeline stages a chunk goes through, in order
+enum ChunkState {
+    CHUNK_QUEUED = 0,   // allocated, terrain not generated yet
+    CHUNK_DECORATED,    // terrain generated and trees placed
+    CHUNK_MESHED,       // CPU mesh built, waiting for its first upload
+    CHUNK_UPLOADED      // mesh uploaded to the GPU, later meshes replace it once uploaded
+};
+
+class Chunk;
+class WorldGenerator;
+
+// the 3x3 chunks around a chunk, missing ones are nullptr
+struct ChunkNeighborhood {
+    Chunk* chunks[3][3] = {};
+
+    Chunk* at(int dx, int dz) const { return chunks[dx + 1][dz + 1]; }
+    Chunk* left() const  { return at(-1, 0); }
+    Chunk* right() const { return at(1, 0); }
+    Chunk* front() const { return at(0, 1); }
+    Chunk* back() const  { return at(0, -1); }
+};
+
+// meshing input: solidity of a chunk section plus a one block border copied from
+// the surrounding chunks and sections, so the mesher never checks bounds or neighbor pointers
+struct ChunkApron {
+    static const int SIZE = CHUNK_SIZE + 2;
+    static const int HEIGHT = SECTION_HEIGHT + 2;
+
+    uint8_t solid[SIZE * HEIGHT * SIZE];
+    ColumnMask columns[SIZE * SIZE]; // bit 0 is the level below the section
+
+    // x, y, z in section coords, -1 to CHUNK_SIZE (SECTION_HEIGHT)
+    static int index(int x, int y, int z) { return (x + 1) + (y + 1) * SIZE + (z + 1) * SIZE * HEIGHT; }
+    bool is_solid(int x, int y, int z) const { return solid[index(x, y, z)]; }
+    ColumnMask column(int x, int z) const { return columns[(x + 1) + (z + 1) * SIZE]; }
+};
 
 class Chunk {
 public:
     Chunk(int x, int z);
     ~Chunk();
 
-    float octave_noise(float x, float z, FastNoiseLite& noise);
-    void generate_blocks();
-    void generate_trees(Chunk* left, Chunk* right, Chunk* front, Chunk* back);
-    int get_ao(bool side1, bool side2, bool corner);
-    bool is_block_solid_at(int x, int y, int z, Chunk* left, Chunk* right, Chunk* front, Chunk* back) const;
-    void build_mesh(Chunk* left, Chunk* right, Chunk* front, Chunk* back);
-    void draw();
+    void generate_blocks(WorldGenerator& generator);
+    void generate_trees(WorldGenerator& generator);
+    int get_ao(bool side1, bool side2, bool corner) const;
+    ColumnMask get_solid_column(int section, int x, int z) const;
+    bool is_section_empty(int section) const;
+    bool is_section_opaque(int section) const;
+    void fill_apron(const ChunkNeighborhood& neighbors, int section, ChunkApron& apron) const;
+    void find_visible_faces(const ChunkApron& apron, ColumnMask visible[6][CHUNK_SIZE * CHUNK_SIZE]) const;
+    ChunkMeshData build_mesh(const ChunkNeighborhood& neighbors, bool greedy = false) const;
+    void upload_mesh(const ChunkMeshData& mesh, QuadIndexBuffer& quadIndices, MeshArena& arena);
+    void queue_draw(MeshArena& arena) const;
+    int get_face_count() const;
+    int get_quad_count() const;
+    void get_mesh_bounds(glm::vec3& min, glm::vec3& max) const; // box around the uploaded mesh
+    const ChunkSection& get_section(int section) const;
+    size_t memory_bytes() const; // block data: sections and solid columns
 
     Block get_block(int x, int y, int z) const;
     void set_block(int x, int y, int z, Block block);
-    void set_block_safe(int x, int y, int z, Block block, Chunk* left, Chunk* right, Chunk* front, Chunk* back);
+
+    // pipeline bookkeeping, only touched from the main thread
+    ChunkState state = CHUNK_QUEUED;
+    bool inFlight = false;      // a job working on this chunk is running
+    bool writing = false;       // a running job writes this chunk's blocks
+    int readers = 0;            // running jobs reading this chunk's blocks
+    bool needsRemesh = false;   // waiting in the world's remesh queue
+    int meshVersion = 0;        // world mesh version of the last meshing job
+    long lastUsed = 0;          // world frame the chunk was loaded or last left the render distance
 
 private:
     int chunkX, chunkZ;
-    std::vector<Block> blocks;
+    std::vector<ChunkSection> sections;
+    std::vector<ColumnMask> solidColumns; // index x + z * CHUNK_SIZE + section * CHUNK_SIZE * CHUNK_SIZE
     bool treesGenerated;
 
-    std::vector<GLfloat> vertices;
-    std::vector<GLuint> indices;
-
-    VAO vao;
-    VBO* vbo = nullptr;
-    EBO* ebo = nullptr;
+    // vertices in the world's mesh arena, given back when the chunk is destroyed
+    MeshRange meshRange;
+    MeshArena* meshArena = nullptr;
+    GLsizei indexCount = 0;
+    int faceCount = 0;
+    int meshMinY = 0, meshMaxY = 0;
 
     int get_index(int x, int y, int z) const;
+    bool can_skip_section(const ChunkNeighborhood& neighbors, int section) const;
+    void place_tree(int x, int y, int z, ChunkRandom& random);
 };
 
 #endif
@@ -0,0 +1,149 @@
+#ifndef CHUNK_MAP_HPP
+#define CHUNK_MAP_HPP
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// map from chunk coords to T, open addressing with linear probing in one flat
+// array. the coords are packed in 64 bits and mixed with the splitmix64
+// finalizer, so neighboring chunks spread over the table. erase shifts the
+// following entries back instead of leaving tombstones, so probes stay short.
+// inserting or erasing invalidates iterators and pointers to values
+template <typename T>
+class ChunkMap {
+public:
+    typedef std::pair<int, int> Key;
+    typedef std::pair<Key, T> Entry;
+
+    template <typename MapType, typename EntryType>
+    class basic_iterator {
+    public:
+        basic_iterator(MapType* map, size_t slot) : map(map), slot(slot) { skip_free(); }
+
+        EntryType& operator*() const { return map->entries[slot]; }
+        EntryType* operator->() const { return &map->entries[slot]; }
+        basic_iterator& operator++() { ++slot; skip_free(); return *this; }
+        bool operator==(const basic_iterator& other) const { return slot == other.slot; }
+        bool operator!=(const basic_iterator& other) const { return slot != other.slot; }
+
+    private:
+        MapType* map;
+        size_t slot;
+
+        void skip_free() {
+            while (slot < map->used.size() && !map->used[slot]) ++slot;
+        }
+    };
+    typedef basic_iterator<ChunkMap, Entry> iterator;
+    typedef basic_iterator<const ChunkMap, const Entry> const_iterator;
+
+    ChunkMap() { rehash(16); }
+
+    // pointer to the value, nullptr when the chunk isn't in the map
+    T* find(int chunkX, int chunkZ) {
+        size_t slot = find_slot(chunkX, chunkZ);
+        return used[slot] ? &entries[slot].second : nullptr;
+    }
+    const T* find(int chunkX, int chunkZ) const {
+        size_t slot = find_slot(chunkX, chunkZ);
+        return used[slot] ? &entries[slot].second : nullptr;
+    }
+    bool contains(const Key& key) const { return find(key.first, key.second) != nullptr; }
+
+    // inserts a default T when the chunk isn't in the map
+    T& operator[](const Key& key) {
+        // grows past half full, linear probes get long quickly after that
+        if ((count + 1) * 2 > used.size())
+            rehash(used.size() * 2);
+
+        size_t slot = find_slot(key.first, key.second);
+        if (!used[slot]) {
+            used[slot] = 1;
+            entries[slot] = Entry(key, T());
+            count++;
+        }
+        return entries[slot].second;
+    }
+
+    bool erase(const Key& key) {
+        size_t slot = find_slot(key.first, key.second);
+        if (!used[slot]) return false;
+
+        // backward shift: moves up every following entry of the probe run
+        // that may sit in the freed slot, the run then has no hole
+        size_t mask = used.size() - 1;
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask; used[next]; next = (next + 1) & mask) {
+            size_t home = home_slot(entries[next].first.first, entries[next].first.second);
+            // the entry can't move when its home is in (hole, next] (cyclically)
+            if (((next - home) & mask) < ((next - hole) & mask)) continue;
+            entries[hole] = std::move(entries[next]);
+            hole = next;
+        }
+        used[hole] = 0;
+        entries[hole] = Entry();
+        count--;
+        return true;
+    }
+
+    void clear() {
+        for (size_t slot = 0; slot < used.size(); ++slot) {
+            if (!used[slot]) continue;
+            used[slot] = 0;
+            entries[slot] = Entry();
+        }
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, used.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, used.size()); }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<uint8_t> used;
+    size_t count = 0;
+
+    static uint64_t hash(int chunkX, int chunkZ) {
+        uint64_t key = (uint64_t(uint32_t(chunkX)) << 32) | uint32_t(chunkZ);
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+        return key ^ (key >> 31);
+    }
+
+    size_t home_slot(int chunkX, int chunkZ) const {
+        return size_t(hash(chunkX, chunkZ)) & (used.size() - 1);
+    }
+
+    // slot holding the key, or the free slot ending its probe run
+    size_t find_slot(int chunkX, int chunkZ) const {
+        size_t mask = used.size() - 1;
+        size_t slot = home_slot(chunkX, chunkZ);
+        while (used[slot] && (entries[slot].first.first != chunkX || entries[slot].first.second != chunkZ))
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void rehash(size_t capacity) {
+        // capacity is a power of two, so the home slot is a mask
+        std::vector<Entry> oldEntries(capacity);
+        std::vector<uint8_t> oldUsed(capacity, 0);
+        oldEntries.swap(entries);
+        oldUsed.swap(used);
+
+        for (size_t slot = 0; slot < oldUsed.size(); ++slot) {
+            if (!oldUsed[slot]) continue;
+            size_t target = find_slot(oldEntries[slot].first.first, oldEntries[slot].first.second);
+            used[target] = 1;
+            entries[target] = std::move(oldEntries[slot]);
+        }
+    }
+};
+
+#endif
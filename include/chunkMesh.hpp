@@ -0,0 +1,31 @@
+#ifndef CHUNK_MESH_HPP
+#define CHUNK_MESH_HPP
+
+#include <vector>
+#include <cstdint>
+#include <glad/glad.h>
+
+// packed chunk vertex, 32 bits, decoded in defaultShader.vert:
+//   bits  0-5   x      block corner in chunk coords (0 - 63)
+//   bits  6-14  y      block corner in chunk coords (0 - 511)
+//   bits 15-20  z      block corner in chunk coords (0 - 63)
+//   bits 21-23  face   -Z, +Z, -X, +X, -Y, +Y (texture uv is derived from it)
+//   bits 24-25  ao     0 (darkest) - 3
+//   bits 26-31  tile   atlas tile index
+inline uint32_t pack_vertex(int x, int y, int z, int face, int ao, int tile) {
+    return uint32_t(x) | (uint32_t(y) << 6) | (uint32_t(z) << 15) |
+           (uint32_t(face) << 21) | (uint32_t(ao) << 24) | (uint32_t(tile) << 26);
+}
+
+// CPU side result of meshing a chunk, doesn't need a GL context
+// 4 vertices per quad, indices come from the shared QuadIndexBuffer
+struct ChunkMeshData {
+    std::vector<uint32_t> vertices;
+    int faceCount = 0; // visible block faces, before greedy merging
+    int minY = 0, maxY = 0; // y range of the block corners, bounds the mesh for occlusion queries
+
+    bool empty() const { return vertices.empty(); }
+    int quad_count() const { return int(vertices.size() / 4); }
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CHUNK_RANDOM_HPP
+#define CHUNK_RANDOM_HPP
+
+#include <cstdint>
+
+// world generation features, each one draws from its own random stream
+// new ones go at the end, changing a value changes every world
+enum GenFeature : uint32_t {
+    FEATURE_TREES = 0
+};
+
+// counter based random numbers for world generation: the n-th value only
+// depends on (seed, chunkX, chunkZ, feature, n), so a chunk comes out the
+// same whatever thread generates it and whatever order chunks are visited in
+class ChunkRandom {
+public:
+    ChunkRandom(uint32_t seed, int chunkX, int chunkZ, uint32_t feature) {
+        key = mix(seed);
+        key = mix(key ^ uint32_t(chunkX));
+        key = mix(key ^ (uint64_t(uint32_t(chunkZ)) << 32));
+        key = mix(key ^ feature);
+    }
+
+    // jump to the n-th value, lets a feature give each column its own range
+    void seek(uint64_t n) { counter = n; }
+
+    uint32_t next() { return uint32_t(mix(key + counter++ * 0x9E3779B97F4A7C15ull) >> 32); }
+
+    // 0 to bound - 1
+    int next_int(int bound) { return int((uint64_t(next()) * uint32_t(bound)) >> 32); }
+
+    // splitmix64 finalizer
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef CHUNK_SECTION_HPP
+#define CHUNK_SECTION_HPP
+
+#include <memory>
+#include "blockStorage.hpp"
+
+// a slice of SECTION_HEIGHT y levels of a chunk. empty (all air) and
+// uniform (one block id) sections keep only that id, mixed ones a BlockStorage
+class ChunkSection {
+public:
+    enum Kind { EMPTY, UNIFORM, MIXED };
+
+    ChunkSection(int volume);
+
+    // index x + y * CHUNK_SIZE + z * CHUNK_SIZE * SECTION_HEIGHT, y in section
+    BlockID get(int index) const { return storage ? storage->get(index) : uniform; }
+    void set(int index, BlockID id);
+    // replaces every block, drops the storage when they are all the same
+    void assign(const BlockID* ids);
+
+    Kind kind() const;
+    BlockID get_uniform() const { return uniform; } // only for EMPTY and UNIFORM
+    const BlockStorage* get_storage() const { return storage.get(); }
+    size_t memory_bytes() const;
+
+private:
+    int volume;
+    BlockID uniform = BLOCK_AIR;
+    std::unique_ptr<BlockStorage> storage;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef MESH_ARENA_HPP
+#define MESH_ARENA_HPP
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "quadIndexBuffer.hpp"
+
+// where a chunk mesh lives in the arena, in vertices. owned by the chunk,
+// the arena moves it (and updates it) when it compacts a page
+struct MeshRange {
+    int page = -1;
+    uint32_t offset = 0;   // first vertex in the page buffer
+    uint32_t capacity = 0; // vertices reserved
+    uint32_t count = 0;    // vertices in use
+    int originX = 0, originZ = 0; // world position added to the vertices by the shader
+
+    bool valid() const { return page >= 0; }
+};
+
+struct MeshArenaStats {
+    size_t totalBytes = 0;       // GL buffer storage of every page
+    size_t usedBytes = 0;        // reserved by meshes
+    size_t largestFreeBytes = 0;
+    float fragmentation = 0.0f;  // 1 - largest free block / free bytes, 0 while free space is one block
+    int pages = 0;
+    int meshes = 0;
+    long inPlaceUploads = 0;     // new mesh written over the previous one
+    long moves = 0;              // meshes that outgrew their range
+    long compactions = 0;
+};
+
+// chunk meshes suballocated from a few large vertex buffers with one VAO
+// each (packed vertex attribute, shared quad indices), so a rebuilt mesh is
+// a glBufferSubData instead of deleting and creating a buffer.
+// first fit over an offset sorted free list, freed ranges merge with their neighbors.
+//
+// ranges start and end on GRANULE vertex boundaries. each page has a texture
+// buffer with the origin of the range owning every granule, the vertex shader
+// reads it at gl_VertexID >> GRANULE_LOG2 (gl_VertexID includes the base
+// vertex), so the meshes of a page are drawn with one multi-draw call
+class MeshArena {
+public:
+    static const int GRANULE_LOG2 = 6;
+    static const uint32_t GRANULE = 1u << GRANULE_LOG2;
+    static const int ORIGIN_TEXTURE_UNIT = 1; // isamplerBuffer rangeOrigins in defaultShader.vert
+
+    MeshArena(QuadIndexBuffer& quadIndices, uint32_t pageVertices = 1u << 20);
+
+    // writes vertices to range, in place when they fit (main thread only)
+    void upload(MeshRange& range, const uint32_t* vertices, uint32_t count, int originX, int originZ);
+    void release(MeshRange& range);
+    // compacts the most fragmented page when enough space is lost, at most one per call
+    void maintain();
+
+    // draws are collected per page, then submitted with one call per page when batched:
+    // glMultiDrawElementsIndirect with GL 4.3, glMultiDrawElementsBaseVertex before.
+    // returns the number of draw calls
+    void queue_draw(const MeshRange& range, GLsizei indexCount);
+    int draw_queued(GLenum indexType, bool batched = true);
+
+    MeshArenaStats get_stats() const;
+    void free();
+
+private:
+    struct FreeBlock {
+        uint32_t offset, size;
+    };
+
+    // layout of glMultiDrawElementsIndirect commands
+    struct DrawCommand {
+        GLuint count, instanceCount, firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    struct Page {
+        GLuint buffer = 0;
+        GLuint vao = 0;
+        GLuint originBuffer = 0;
+        GLuint originTexture = 0;
+        uint32_t capacity = 0; // 0 once released
+        std::vector<FreeBlock> freeBlocks; // sorted by offset
+        std::vector<MeshRange*> ranges;    // meshes in the page, updated on compaction
+        std::vector<int32_t> origins;      // x, z per granule, copy of originBuffer
+
+        // queued draws, cleared once submitted
+        std::vector<GLsizei> drawCounts;
+        std::vector<GLint> drawBaseVertices;
+    };
+
+    QuadIndexBuffer& quadIndices;
+    uint32_t pageVertices;
+    std::vector<Page> pages;
+    MeshArenaStats counters;
+
+    GLuint indirectBuffer = 0;
+    std::vector<DrawCommand> drawCommands;
+    std::vector<const void*> drawIndices; // every draw starts at index 0
+
+    bool allocate(int page, uint32_t size, MeshRange& range);
+    int create_page(uint32_t capacity);
+    void free_page(Page& page);
+    void add_free(Page& page, uint32_t offset, uint32_t size);
+    void link_vao(Page& page);
+    void write_origins(Page& page, const MeshRange& range);
+    void bind_page(Page& page);
+    void compact(int page);
+    static float fragmentation(const Page& page, uint32_t& freeSize, uint32_t& largest);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "chunkMap.hpp"
+#include "shaderClass.hpp"
+#include "VAO.hpp"
+#include "VBO.hpp"
+
+// hardware occlusion culling of chunks: the bounding box of every chunk in the
+// frustum is drawn against the frame's depth buffer inside a GL_ANY_SAMPLES_PASSED
+// query, and the result decides whether the chunk is drawn next frame. results are
+// read one frame late and only once available, so the CPU never waits on the GPU
+class OcclusionCuller {
+public:
+    // false when the last query saw none of the box. chunks without a recent
+    // result (just loaded, back in the frustum, query still running) and boxes
+    // around the camera count as visible
+    bool is_visible(int chunkX, int chunkZ, const glm::vec3& boxMin, const glm::vec3& boxMax, long frame);
+
+    // queries are issued between begin and end, after the chunks are drawn
+    void begin_queries(Shader& shader);
+    void query(int chunkX, int chunkZ, const glm::vec3& boxMin, const glm::vec3& boxMax, long frame);
+    void end_queries();
+
+    void set_camera(const glm::vec3& position) { cameraPosition = position; }
+    void forget(int chunkX, int chunkZ); // the chunk left the render distance
+    void free();
+
+private:
+    struct Query {
+        GLuint ID = 0;
+        long frame = -1;     // frame the query was issued
+        bool pending = false; // issued, result not read yet
+        bool visible = true;  // last result read
+    };
+
+    ChunkMap<Query> queries;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    Shader* boxShader = nullptr;
+
+    // unit cube, GL objects are created on first use
+    VAO* vao = nullptr;
+    VBO* vbo = nullptr;
+
+    bool contains_camera(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
+
+#endif
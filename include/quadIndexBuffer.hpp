@@ -0,0 +1,29 @@
+#ifndef QUAD_INDEX_BUFFER_HPP
+#define QUAD_INDEX_BUFFER_HPP
+
+#include <glad/glad.h>
+#include <vector>
+
+// One element buffer shared by every chunk VAO, chunk meshes are lists of
+// quads so their indices are always 0, 1, 2, 0, 2, 3 (+4 per quad).
+// Uses 16 bit indices while the capacity allows it.
+class QuadIndexBuffer {
+public:
+    QuadIndexBuffer(int initialQuads);
+
+    void reserve(int quads);
+    void bind();
+    void free();
+    GLenum index_type() const;
+
+private:
+    GLuint ID = 0;
+    int capacity = 0;
+    int initialQuads;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+
+    template <typename T>
+    void fill(std::vector<T>& indices, int quads);
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -19,10 +20,28 @@ class Shader {
         Shader(const char* vertexFile, const char* fragmentFile);
         void activate();
         void free();
-        void set_mat4(const std::string &name, const glm::mat4 &mat) const;
-        void set_bool(const std::string &name, const bool b) const;
+        // the program has to be active. a value equal to the last one
+        // set is skipped, unknown names (optimized out uniforms) are ignored
+        void set_mat4(const char* name, const glm::mat4 &mat);
+        void set_bool(const char* name, const bool b);
+        void set_int(const char* name, const int i);
+        void set_vec3(const char* name, const glm::vec3 &vec);
+        // uniform block of the program --> buffer binding point, ignored when the program has no such block
+        void set_block_binding(const char* name, GLuint binding);
 
     private:
+        // an active uniform, resolved once the program is linked
+        struct Uniform {
+            std::string name;
+            GLint location;
+            float value[16]; // last value set, as many floats/ints as the type holds
+            bool hasValue = false;
+        };
+        std::vector<Uniform> uniforms; // a handful per program, scanned linearly
+
+        void resolve_uniforms();
+        Uniform* find_uniform(const char* name);
+        bool changed(Uniform& uniform, const void* value, size_t bytes);
         void compile_errors(unsigned int shader, const char* type);
 };
 
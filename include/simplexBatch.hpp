@@ -0,0 +1,24 @@
+#ifndef SIMPLEX_BATCH_HPP
+#define SIMPLEX_BATCH_HPP
+
+// FastNoiseLite's 2D OpenSimplex2 (no fractal) for many points at once.
+// same operations in the same order as FastNoiseLite::GetNoise, so results
+// are bit identical as long as the compiler doesn't contract the scalar
+// path into FMA (-ffp-contract / -march with FMA), then they stay within 1e-6
+class SimplexBatch {
+public:
+    SimplexBatch(int seed, float frequency);
+
+    // out[i] = noise at (x[i], y[i]), AVX2 or SSE4.1 lanes when the CPU has them
+    void evaluate(const float* x, const float* y, float* out, int count) const;
+    float evaluate(float x, float y) const;
+
+    // instruction set picked at startup: "avx2", "sse4.1" or "scalar"
+    static const char* simd_name();
+
+private:
+    int seed;
+    float frequency;
+};
+
+#endif
@@ -2,12 +2,54 @@
 #define WORLD_HPP
 
 #include <iostream>
-#include <unordered_map>
 #include <memory>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <optional>
 #include <glm/glm.hpp>
 
 #include "chunk.hpp"
+#include "chunkMap.hpp"
+#include "meshArena.hpp"
+#include "occlusionCuller.hpp"
 #include "frustrum.hpp"
+#include "threadPool.hpp"
+#include "worldGenerator.hpp"
+
+struct MeshStats {
+    int drawnChunks = 0;
+    long faces = 0; // visible block faces of the drawn chunks
+    long quads = 0; // quads actually drawn, less than faces with greedy meshing
+    int drawCalls = 0;
+    float submitUs = 0.0f; // CPU time of render: culling, draw submission and occlusion queries
+    int occludedChunks = 0; // in the frustum, skipped by occlusion culling
+    long occludedQuads = 0;
+};
+
+struct RemeshStats {
+    long requested = 0; // remesh requests (block edits, neighbors loading)
+    long coalesced = 0; // requests absorbed by an already queued remesh
+    long built = 0;     // remeshes actually built
+};
+
+struct LoadStats {
+    int missingChunks = 0;      // active chunks without an uploaded mesh
+    int queuedLoads = 0;        // chunks waiting for their generation job
+    int queuedMeshes = 0;       // active chunks waiting for their first meshing job
+    double firstFullViewMs = 0; // from the first update to every active chunk uploaded
+    double lastFullViewMs = 0;  // same, for the last time the view had holes (start, teleports, fast moves)
+};
+
+struct UploadStats {
+    int pending = 0;    // meshes built on the pool, waiting for their upload
+    long uploaded = 0;  // meshes uploaded so far
+    float p50Us = 0.0f; // upload time per frame, over the recent frames that uploaded something
+    float p99Us = 0.0f;
+};
 
 struct RaycastHit {
     bool hit = false;
@@ -15,32 +57,143 @@ struct RaycastHit {
     glm::ivec3 hitNormal; // block's face hit
 };
 
+// called on the main thread when a chunk enters or leaves the render distance,
+// the chunk stays loaded at least until the listeners return
+typedef std::function<void(int chunkX, int chunkZ, Chunk* chunk)> ChunkListener;
+
 class World {
 private:
-    struct pair_hash {
-        std::size_t operator()(const std::pair<int, int>& p) const {
-            return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
-        }
+    // a pipeline stage running on the worker pool
+    struct ChunkJob {
+        int chunkX, chunkZ;
+        Chunk* chunk;
+        ChunkState stage;                // state the chunk reaches once the job is done
+        std::vector<Chunk*> readChunks;  // chunks whose blocks the job reads
+        std::vector<Chunk*> writeChunks; // chunks whose blocks the job writes
+        ChunkMeshData mesh;              // filled by meshing jobs
+        float workUs = 0.0f;             // time the job took on its worker
+    };
+
+    // a mesh built on the pool, the chunk draws its previous one until it's uploaded
+    struct ReadyMesh {
+        int chunkX, chunkZ;
+        Chunk* chunk;
+        ChunkMeshData mesh;
+        float priority = 0.0f;
+    };
+
+    struct BlockEdit {
+        glm::ivec3 pos;
+        Block block;
     };
 
-    int renderDistance = 8;
-    std::unordered_map<std::pair<int, int>, std::unique_ptr<Chunk>, pair_hash> worldChunks;
-    std::unordered_map<std::pair<int, int>, Chunk*, pair_hash> activeChunks;
+    WorldGenerator generator; // same seed, same world
+    // distances in chunks, so the view reaches as far whatever the chunk size
+    int renderDistance = 64 / CHUNK_SIZE;
+    int unloadDistance = renderDistance + 3; // past the load distance so chunks don't flicker at the edge
+    size_t chunkBudget = 65536 / (CHUNK_SIZE * CHUNK_SIZE); // loaded chunks kept before evicting the least recently used
+    long frame = 0;
+    bool greedyMeshing = true;
+    int meshVersion = 0;        // bumped when a setting changes every mesh
+    bool batchedDrawing = true; // one multi-draw call per arena page instead of one draw per chunk
+    bool occlusionCulling = true;
+
+    // view the active set was built for, it only changes when the player
+    // crosses a chunk border or the render distance changes
+    bool viewValid = false;
+    int viewX = 0, viewZ = 0;
+    int viewDistance = 0;
+    bool unloadPending = false; // unloading still has work, the view moved or a chunk was busy
+
+    // what the player sees, to prioritize queued jobs
+    glm::vec3 playerPosition = glm::vec3(0.0f);
+    glm::vec3 cameraFront = glm::vec3(0.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    bool hasViewProjection = false; // set by the first render
+
+    int jobsInFlight = 0;
+    // running averages, queued jobs are dispatched a couple of frames of work at a time
+    float jobUs = 100.0f;
+    float frameUs = 16000.0f;
+    std::chrono::steady_clock::time_point lastUpdate;
+    LoadStats loadStats;
+    bool filling = false; // some active chunk isn't uploaded yet
+    std::chrono::steady_clock::time_point fillStart;
+
+    MeshStats meshStats;
+    RemeshStats remeshStats;
+    // declared before the chunks, which give their mesh ranges back when destroyed
+    QuadIndexBuffer quadIndices;
+    MeshArena meshArena;
+    OcclusionCuller occlusion;
+    std::vector<ChunkMap<Chunk*>::Entry> queriedChunks; // meshed chunks in the frustum, reused every frame
+    ChunkMap<std::unique_ptr<Chunk>> worldChunks;
+    ChunkMap<Chunk*> activeChunks;
+
+    ThreadPool pool;
+    std::mutex finishedMutex;
+    std::vector<ChunkJob> finishedJobs;
+    std::vector<BlockEdit> pendingEdits; // edits on chunks a job was using
+    std::vector<std::pair<int, int>> remeshQueue; // dirty chunks, one entry each
+    std::vector<std::pair<int, int>> loadQueue;   // allocated chunks waiting for generation
+    std::vector<std::pair<int, int>> meshQueue;   // active chunks waiting for their first mesh
+    std::vector<ReadyMesh> readyMeshes;
+
+    // per frame, 0 for no limit
+    size_t uploadBudgetBytes = 512 * 1024;
+    float uploadBudgetUs = 2000.0f;
+    long uploadedMeshes = 0;
+    std::vector<float> uploadTimes; // recent frames, used as a ring
+    size_t uploadTimesNext = 0;
+
+    std::vector<ChunkListener> enterListeners;
+    std::vector<ChunkListener> leaveListeners;
 
-    
     Chunk* get_chunk(int chunkX, int chunkZ);
-    void load_chunk(int chunkX, int chunkZ);
+    ChunkNeighborhood get_neighborhood(int chunkX, int chunkZ);
+    Chunk* load_chunk(int chunkX, int chunkZ);
+    void move_view(int playerChunkX, int playerChunkZ);
+    float chunk_priority(int chunkX, int chunkZ, const std::optional<Frustum>& frustum) const;
+    void dispatch_queued();
+    void dispatch_generation(int chunkX, int chunkZ, Chunk* chunk);
+    void update_fill(int missingDelta);
+    void upload_ready_meshes();
+    void dispatch_job(ChunkJob job, std::function<void(ChunkJob&)> work);
+    void collect_finished_jobs();
+    void apply_pending_edits();
+    void mark_for_remesh(int chunkX, int chunkZ);
+    void mark_neighbors_for_remesh(int chunkX, int chunkZ);
+    void drain_remesh_queue();
+    bool dispatch_mesh(int chunkX, int chunkZ, Chunk* chunk);
+    void unload_chunks(int playerChunkX, int playerChunkZ);
 
 public:
     World();
+    World(uint32_t seed);
     void free();
 
-    void update(const glm::vec3& playerPos);
-    void render(const glm::mat4 &view, const glm::mat4 &projection);
+    // front (camera direction) weights loading toward where the player looks
+    void update(const glm::vec3& playerPos, const glm::vec3& front = glm::vec3(0.0f));
+    // boxShader draws the bounding boxes of the occlusion queries
+    void render(Shader& boxShader, const glm::mat4 &view, const glm::mat4 &projection);
+    void set_greedy_meshing(bool enabled);
+    void set_batched_drawing(bool enabled);
+    void set_occlusion_culling(bool enabled);
+    MeshStats get_mesh_stats() const;
+    RemeshStats get_remesh_stats() const;
+    LoadStats get_load_stats() const;
+    UploadStats get_upload_stats() const;
+    MeshArenaStats get_arena_stats() const;
+    void set_upload_budget(size_t bytesPerFrame, float usPerFrame);
+    void set_chunk_budget(size_t budget);
+    void set_render_distance(int distance);
+    int get_render_distance() const;
+    void on_chunk_enter(ChunkListener listener);
+    void on_chunk_leave(ChunkListener listener);
+    size_t get_loaded_chunk_count() const;
 
     Block get_block(int worldX, int worldY, int worldZ) const;
     void set_block(int worldX, int worldY, int worldZ, Block block);
-    void generate_all_trees();
     RaycastHit raycast(const glm::vec3& origin, const glm::vec3& direction, float reach) const;
 
     bool freed;
@@ -0,0 +1,49 @@
+#ifndef WORLD_GENERATOR_HPP
+#define WORLD_GENERATOR_HPP
+
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "FastNoiseLite.hpp"
+#include "simplexBatch.hpp"
+#include "chunk.hpp"
+#include "chunkMap.hpp"
+
+// surface block y of every column of a chunk, index x + z * CHUNK_SIZE
+struct ColumnHeights {
+    int16_t height[CHUNK_SIZE * CHUNK_SIZE];
+
+    int at(int x, int z) const { return height[x + z * CHUNK_SIZE]; }
+};
+
+// world generation shared by all worker threads: noise configured once
+// from the seed and a cache of column heights, so terrain and the trees of
+// the 8 neighbors don't evaluate the same octaves again
+class WorldGenerator {
+public:
+    WorldGenerator(uint32_t seed);
+
+    uint32_t get_seed() const;
+    float tree_chance(int worldX, int worldZ) const;
+
+    // cached, safe to call from any thread
+    std::shared_ptr<const ColumnHeights> get_heights(int chunkX, int chunkZ);
+    int get_height(int worldX, int worldZ);
+
+    // drops cached heights more than distance chunks away from a chunk
+    void forget_heights(int chunkX, int chunkZ, int distance);
+    size_t cached_height_chunks();
+
+private:
+    uint32_t seed;
+    // both are read only, one instance per noise is shared by every thread
+    SimplexBatch terrainNoise; // same as FastNoiseLite OpenSimplex2, a chunk at a time
+    FastNoiseLite treeNoise;
+
+    std::mutex heightsMutex;
+    ChunkMap<std::shared_ptr<const ColumnHeights>> heights;
+
+    void compute_heights(int chunkX, int chunkZ, ColumnHeights& heights) const;
+};
+
+#endif
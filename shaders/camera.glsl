@@ -0,0 +1,11 @@
+// per frame camera data shared by every program, see CameraData in cameraBuffer.hpp.
+// Shader inserts this file after the #version line of every stage
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    vec4 fogColor;
+    float fogStart;
+    float fogEnd;
+    int underWater;
+};
@@ -5,17 +5,21 @@ out vec4 FragColor;
 in vec2 TexCoord;
 in vec3 posSCO;
 in float ao;
+flat in int tile;
 
 uniform sampler2D atlas;
-uniform int underWater;
 
 void main() {
-    const vec4 fogColor = vec4(0.35, 0.8, 1.0, 1.0);
-    float dMin = 5.0, dMax = 64.0;
     float d = length(posSCO);
-    float f = smoothstep(dMin, dMax, d);
-
-    vec4 texColor = texture(atlas, TexCoord);
+    float f = smoothstep(fogStart, fogEnd, d);
+
+    // TexCoord is tile local and repeats over merged quads,
+    // gradients come from the unwrapped coords to keep mip selection seamless
+    const vec2 atlasSize = vec2(4.0, 2.0);
+    vec2 tileOrigin = vec2(tile % 4, atlasSize.y - 1.0 - float(tile / 4));
+    vec2 atlasCoord = (tileOrigin + fract(TexCoord)) / atlasSize;
+    vec2 gradCoord = TexCoord / atlasSize;
+    vec4 texColor = textureGrad(atlas, atlasCoord, dFdx(gradCoord), dFdy(gradCoord));
 
     float brightness = mix(0.6, 1.0, ao);
     texColor = vec4(texColor.rgb * brightness, texColor.a);
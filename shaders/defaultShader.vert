@@ -1,21 +1,37 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in float aAO;
+// packed vertex, see pack_vertex in chunkMesh.hpp
+layout (location = 0) in uint aData;
 
 out vec2 TexCoord;
 out vec3 posSCO;
 out float ao;
+flat out int tile;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// world x, z of the chunk owning each 64 vertex granule of the arena page (see MeshArena)
+uniform isamplerBuffer rangeOrigins;
+
+// tile uv axes per face (-Z, +Z, -X, +X, -Y, +Y), same orientation
+// as the face corners in Chunk::build_mesh
+const vec3 uAxes[6] = vec3[6](vec3(-1, 0, 0), vec3(1, 0, 0), vec3(0, 0, 1),
+                              vec3(0, 0, -1), vec3(1, 0, 0), vec3(1, 0, 0));
+const vec3 vAxes[6] = vec3[6](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 1, 0),
+                              vec3(0, 1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
 
 void main() {
-    vec4 pos = view * model * vec4(aPos, 1.0);
+    vec3 localPos = vec3(float(aData & 63u), float((aData >> 6) & 511u), float((aData >> 15) & 63u));
+    int face = int((aData >> 21) & 7u);
+
+    // block corners --> block centered world coords,
+    // gl_VertexID includes the chunk's base vertex
+    ivec2 origin = texelFetch(rangeOrigins, gl_VertexID >> 6).xy;
+    vec3 worldPos = vec3(origin.x, 0.0, origin.y) + localPos - 0.5;
+
+    vec4 pos = view * model * vec4(worldPos, 1.0);
     posSCO = pos.xyz;
-    ao = aAO;
+    ao = float((aData >> 24) & 3u) / 3.0;
     gl_Position = projection * pos;
-    TexCoord = aTexCoord;
+    TexCoord = vec2(dot(localPos, uAxes[face]), dot(localPos, vAxes[face]));
+    tile = int(aData >> 26);
 }
\ No newline at end of file
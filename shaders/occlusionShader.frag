@@ -0,0 +1,8 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// color writes are off, only the depth test of the box counts
+void main() {
+    FragColor = vec4(1.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// unit cube, stretched over a chunk's bounding box
+layout (location = 0) in vec3 aPos;
+
+uniform vec3 boxMin;
+uniform vec3 boxSize;
+
+void main() {
+    gl_Position = projection * view * vec4(boxMin + aPos * boxSize, 1.0);
+}
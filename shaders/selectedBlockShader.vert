@@ -6,8 +6,6 @@ layout(location = 1) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main() {
     TexCoord = aTexCoord;
@@ -1,6 +1,6 @@
 #include "EBO.hpp"
 
-EBO::EBO(GLuint* indices, GLsizeiptr size) {
+EBO::EBO(const GLuint* indices, GLsizeiptr size) {
     glGenBuffers(1, &ID);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
@@ -0,0 +1,447 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.hpp"
+#include "chunkMap.hpp"
+#include "threadPool.hpp"
+#include "worldGenerator.hpp"
+#include "simplexBatch.hpp"
+#include "FastNoiseLite.hpp"
+
+using BenchClock = std::chrono::steady_clock;
+
+// every benchmark world is generated from this seed
+const uint32_t BENCH_SEED = 1234;
+
+// hash of the generation check area for BENCH_SEED, update it only when
+// world generation is changed on purpose. trees are placed per chunk, so
+// it only holds for the default 8x30x8 chunks
+const uint64_t GOLDEN_WORLD_HASH = 0xE42D095795B1DC4Dull;
+const bool HAS_GOLDEN_HASH = CHUNK_SIZE == 8 && CHUNK_HEIGHT == 30;
+
+// blocks from the player to the edge of the view, World's render distance at any chunk size
+const int VIEW_RADIUS = 64;
+
+// 3x3 chunks, meshing always looks at the center one
+struct ChunkGrid {
+    std::unique_ptr<Chunk> chunks[3][3];
+
+    Chunk* at(int dx, int dz) { return chunks[dx + 1][dz + 1].get(); }
+    Chunk* center() { return at(0, 0); }
+    Chunk* left()   { return at(-1, 0); }
+    Chunk* right()  { return at(1, 0); }
+    Chunk* front()  { return at(0, 1); }
+    Chunk* back()   { return at(0, -1); }
+
+    ChunkNeighborhood neighborhood() {
+        ChunkNeighborhood neighbors;
+        for (int dx = -1; dx <= 1; ++dx)
+            for (int dz = -1; dz <= 1; ++dz)
+                neighbors.chunks[dx + 1][dz + 1] = at(dx, dz);
+        return neighbors;
+    }
+};
+
+static void make_terrain_grid(ChunkGrid& grid, int chunkX, int chunkZ) {
+    WorldGenerator generator(BENCH_SEED);
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            grid.chunks[dx + 1][dz + 1] = std::make_unique<Chunk>(chunkX + dx, chunkZ + dz);
+            grid.at(dx, dz)->generate_blocks(generator);
+            grid.at(dx, dz)->generate_trees(generator);
+        }
+    }
+}
+
+static void make_checkerboard_grid(ChunkGrid& grid) {
+    // worst case for face culling, every solid block shows all six faces
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            grid.chunks[dx + 1][dz + 1] = std::make_unique<Chunk>(dx, dz);
+            Chunk* chunk = grid.at(dx, dz);
+            for (int x = 0; x < CHUNK_SIZE; ++x)
+                for (int y = 0; y < CHUNK_HEIGHT; ++y)
+                    for (int z = 0; z < CHUNK_SIZE; ++z)
+                        if ((x + y + z) % 2 == 0)
+                            chunk->set_block(x, y, z, BLOCK_STONE);
+        }
+    }
+}
+
+// previous per block visibility test, kept as the baseline to compare against
+// (one section at a time, bit 0 is the bottom level of the section)
+static void find_visible_faces_per_block(Chunk* chunk, Chunk* left, Chunk* right, Chunk* front, Chunk* back,
+                                         int section, ColumnMask visible[6][CHUNK_SIZE * CHUNK_SIZE]) {
+    std::memset(visible, 0, sizeof(ColumnMask) * 6 * CHUNK_SIZE * CHUNK_SIZE);
+    int baseY = section * SECTION_HEIGHT;
+    int topY = std::min(baseY + SECTION_HEIGHT, CHUNK_HEIGHT);
+
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int y = baseY; y < topY; ++y) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                if (!chunk->get_block(x, y, z).is_solid()) continue;
+
+                for (int face = 0; face < 6; ++face) {
+                    bool drawFace = false;
+
+                    switch (face) {
+                        case 0: drawFace = (z == 0) ? !back || !back->get_block(x, y, CHUNK_SIZE - 1).is_solid() : !chunk->get_block(x, y, z - 1).is_solid(); break;
+                        case 1: drawFace = (z == CHUNK_SIZE - 1) ? !front || !front->get_block(x, y, 0).is_solid() : !chunk->get_block(x, y, z + 1).is_solid(); break;
+                        case 2: drawFace = (x == 0) ? !left || !left->get_block(CHUNK_SIZE - 1, y, z).is_solid() : !chunk->get_block(x - 1, y, z).is_solid(); break;
+                        case 3: drawFace = (x == CHUNK_SIZE - 1) ? !right || !right->get_block(0, y, z).is_solid() : !chunk->get_block(x + 1, y, z).is_solid(); break;
+                        case 4: drawFace = (y == 0) ? true : !chunk->get_block(x, y - 1, z).is_solid(); break;
+                        case 5: drawFace = (y == CHUNK_HEIGHT - 1) ? true : !chunk->get_block(x, y + 1, z).is_solid(); break;
+                    }
+
+                    if (drawFace)
+                        visible[face][x + z * CHUNK_SIZE] |= ColumnMask(1) << (y - baseY);
+                }
+            }
+        }
+    }
+}
+
+template <typename Func>
+static double time_per_call_us(int iterations, Func func) {
+    auto start = BenchClock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    std::chrono::duration<double, std::micro> elapsed = BenchClock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static void bench_face_culling(const char* name, ChunkGrid& grid) {
+    const int iterations = 20000;
+    ColumnMask perBlock[6][CHUNK_SIZE * CHUNK_SIZE];
+    ColumnMask bitmask[6][CHUNK_SIZE * CHUNK_SIZE];
+    Chunk* chunk = grid.center();
+    ChunkNeighborhood neighbors = grid.neighborhood();
+    ChunkApron apron;
+
+    // every section of the chunk per call, compared section by section
+    bool same = true;
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        find_visible_faces_per_block(chunk, grid.left(), grid.right(), grid.front(), grid.back(), section, perBlock);
+        chunk->fill_apron(neighbors, section, apron);
+        chunk->find_visible_faces(apron, bitmask);
+        if (std::memcmp(perBlock, bitmask, sizeof(perBlock)) != 0) same = false;
+    }
+
+    double perBlockUs = time_per_call_us(iterations, [&]() {
+        for (int section = 0; section < SECTION_COUNT; ++section)
+            find_visible_faces_per_block(chunk, grid.left(), grid.right(), grid.front(), grid.back(), section, perBlock);
+    });
+    double apronUs = time_per_call_us(iterations, [&]() {
+        for (int section = 0; section < SECTION_COUNT; ++section)
+            chunk->fill_apron(neighbors, section, apron);
+    });
+    std::vector<ChunkApron> aprons(SECTION_COUNT);
+    for (int section = 0; section < SECTION_COUNT; ++section)
+        chunk->fill_apron(neighbors, section, aprons[section]);
+    double bitmaskUs = time_per_call_us(iterations, [&]() {
+        for (int section = 0; section < SECTION_COUNT; ++section)
+            chunk->find_visible_faces(aprons[section], bitmask);
+    });
+    double meshUs = time_per_call_us(iterations / 20, [&]() {
+        chunk->build_mesh(neighbors, true);
+    });
+
+    std::cout << "  " << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(2)
+              << " per block " << std::setw(8) << perBlockUs << " us"
+              << "   bitmask " << std::setw(6) << bitmaskUs << " us"
+              << "   speedup " << std::setw(6) << perBlockUs / bitmaskUs << "x"
+              << "   apron copy " << std::setw(6) << apronUs << " us"
+              << "   full mesh " << std::setw(8) << meshUs << " us"
+              << (same ? "" : "   MISMATCH") << "\n";
+}
+
+static uint64_t hash_chunk(const Chunk& chunk, uint64_t hash) {
+    // FNV-1a over the block ids
+    for (int x = 0; x < CHUNK_SIZE; ++x) {
+        for (int y = 0; y < CHUNK_HEIGHT; ++y) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                hash ^= uint64_t(chunk.get_block(x, y, z).ID);
+                hash *= 0x100000001B3ull;
+            }
+        }
+    }
+    return hash;
+}
+
+static uint64_t generate_area_hash(int threadCount, bool reversed, double& usPerChunk) {
+    // generates a 9x9 chunk area on a pool, hashed in a fixed order afterwards
+    const int radius = 4;
+    const int side = radius * 2 + 1;
+    std::vector<std::unique_ptr<Chunk>> chunks(side * side);
+    for (int i = 0; i < side * side; ++i)
+        chunks[i] = std::make_unique<Chunk>(i % side - radius, i / side - radius);
+
+    auto start = BenchClock::now();
+    {
+        WorldGenerator generator(BENCH_SEED);
+        ThreadPool pool(threadCount);
+        std::atomic<int> remaining(side * side);
+        for (int n = 0; n < side * side; ++n) {
+            Chunk* chunk = chunks[reversed ? side * side - 1 - n : n].get();
+            pool.submit([chunk, &generator, &remaining]() {
+                chunk->generate_blocks(generator);
+                chunk->generate_trees(generator);
+                remaining--;
+            });
+        }
+        while (remaining > 0)
+            std::this_thread::yield();
+    }
+    std::chrono::duration<double, std::micro> elapsed = BenchClock::now() - start;
+    usPerChunk = elapsed.count() / (side * side);
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const auto& chunk : chunks)
+        hash = hash_chunk(*chunk, hash);
+    return hash;
+}
+
+static bool check_generation() {
+    // same seed has to give the same blocks, whatever the thread count or order
+    double singleUs, parallelUs;
+    uint64_t single = generate_area_hash(1, false, singleUs);
+    uint64_t parallel = generate_area_hash(4, true, parallelUs);
+
+    bool golden = !HAS_GOLDEN_HASH || single == GOLDEN_WORLD_HASH;
+    bool ok = single == parallel && golden;
+    std::cout << "World generation (seed " << BENCH_SEED << ")\n"
+              << "  hash 0x" << std::hex << std::setw(16) << std::setfill('0') << single
+              << std::dec << std::setfill(' ')
+              << (single == parallel ? "" : "   MISMATCH between 1 and 4 threads")
+              << (HAS_GOLDEN_HASH ? "" : "   (no golden hash for this chunk size)")
+              << (golden ? "" : "   MISMATCH with golden hash") << "\n"
+              << std::fixed << std::setprecision(2)
+              << "  1 thread " << singleUs << " us per chunk   4 threads " << parallelUs << " us per chunk\n";
+    return ok;
+}
+
+static void bench_noise() {
+    // terrain heightmap noise, 4 octaves per column like WorldGenerator
+    const int side = 256;
+    const int columns = side * side;
+    const float baseFrequency = 0.5f;
+    std::vector<float> x(columns), z(columns), scalar(columns), batch(columns);
+
+    FastNoiseLite noise;
+    noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    noise.SetFrequency(0.01f);
+    noise.SetSeed((int)BENCH_SEED);
+    SimplexBatch simplex((int)BENCH_SEED, 0.01f);
+
+    // centered on 0 so negative coordinates are covered too
+    for (int i = 0; i < columns; ++i) {
+        x[i] = (i % side - side / 2) * baseFrequency;
+        z[i] = (i / side - side / 2) * baseFrequency;
+    }
+
+    int mismatches = 0;
+    float maxError = 0.0f;
+    std::vector<float> octaveX(columns), octaveZ(columns);
+    double scalarUs = time_per_call_us(5, [&]() {
+        float frequency = 1.0f;
+        for (int octave = 0; octave < 4; ++octave, frequency *= 2.0f)
+            for (int i = 0; i < columns; ++i)
+                scalar[i] = noise.GetNoise(x[i] * frequency, z[i] * frequency);
+    });
+    double batchUs = time_per_call_us(5, [&]() {
+        float frequency = 1.0f;
+        for (int octave = 0; octave < 4; ++octave, frequency *= 2.0f) {
+            for (int i = 0; i < columns; ++i) {
+                octaveX[i] = x[i] * frequency;
+                octaveZ[i] = z[i] * frequency;
+            }
+            simplex.evaluate(octaveX.data(), octaveZ.data(), batch.data(), columns);
+        }
+    });
+
+    // both hold the last octave
+    for (int i = 0; i < columns; ++i) {
+        float error = std::fabs(scalar[i] - batch[i]);
+        if (scalar[i] != batch[i]) mismatches++;
+        if (error > maxError) maxError = error;
+    }
+
+    std::cout << "Terrain noise (4 octaves, " << columns << " columns)\n" << std::fixed << std::setprecision(2)
+              << "  FastNoiseLite " << columns / scalarUs << " M columns/s"
+              << "   batch " << SimplexBatch::simd_name() << " " << columns / batchUs << " M columns/s"
+              << "   speedup " << scalarUs / batchUs << "x"
+              << "   not bit identical " << mismatches << " (max error " << std::scientific << maxError << ")\n"
+              << std::fixed;
+}
+
+static void bench_chunk_size() {
+    // everything World loads for one view, comparable between builds with
+    // different chunk sizes (cmake -DCHUNK_SIZE_LOG2=3, 4 or 5)
+    const int renderDistance = VIEW_RADIUS / CHUNK_SIZE;
+    const int side = renderDistance * 2 + 1;
+    const int loaded = side + 2; // meshing needs the ring around the view
+    std::vector<std::unique_ptr<Chunk>> chunks(loaded * loaded);
+    auto at = [&](int dx, int dz) { return chunks[(dx + renderDistance + 1) + (dz + renderDistance + 1) * loaded].get(); };
+
+    WorldGenerator generator(BENCH_SEED);
+    auto start = BenchClock::now();
+    for (int i = 0; i < loaded * loaded; ++i) {
+        chunks[i] = std::make_unique<Chunk>(i % loaded - renderDistance - 1, i / loaded - renderDistance - 1);
+        chunks[i]->generate_blocks(generator);
+        chunks[i]->generate_trees(generator);
+    }
+    std::chrono::duration<double, std::milli> generationMs = BenchClock::now() - start;
+
+    int drawCalls = 0;
+    size_t blockBytes = 0;
+    size_t meshBytes = 0;
+    start = BenchClock::now();
+    for (int dx = -renderDistance; dx <= renderDistance; ++dx) {
+        for (int dz = -renderDistance; dz <= renderDistance; ++dz) {
+            ChunkNeighborhood neighbors;
+            for (int nx = -1; nx <= 1; ++nx)
+                for (int nz = -1; nz <= 1; ++nz)
+                    neighbors.chunks[nx + 1][nz + 1] = at(dx + nx, dz + nz);
+
+            ChunkMeshData mesh = at(dx, dz)->build_mesh(neighbors, true);
+            if (!mesh.empty()) drawCalls++;
+            blockBytes += at(dx, dz)->memory_bytes();
+            meshBytes += mesh.vertices.size() * sizeof(uint32_t);
+        }
+    }
+    std::chrono::duration<double, std::milli> meshingMs = BenchClock::now() - start;
+
+    int viewBlocks = side * CHUNK_SIZE;
+    std::cout << "Chunk size " << CHUNK_SIZE << "x" << CHUNK_HEIGHT << "x" << CHUNK_SIZE
+              << " (" << side << "x" << side << " chunks, " << viewBlocks << "x" << viewBlocks << " blocks in view)\n"
+              << std::fixed << std::setprecision(2)
+              << "  generation " << generationMs.count() << " ms (" << loaded * loaded << " chunks)"
+              << "   meshing " << meshingMs.count() << " ms"
+              << "   draw calls " << drawCalls << "\n"
+              << "  block data " << blockBytes / 1024 << " KB"
+              << "   mesh " << meshBytes / 1024 << " KB"
+              << "   per 1k columns: generation " << generationMs.count() * 1000.0 / (loaded * loaded * CHUNK_SIZE * CHUNK_SIZE)
+              << " ms   meshing " << meshingMs.count() * 1000.0 / (viewBlocks * viewBlocks) << " ms\n";
+}
+
+// previous chunk map hash, kept as the baseline to compare against
+struct XorPairHash {
+    std::size_t operator()(const std::pair<int, int>& p) const {
+        return std::hash<int>()(p.first) ^ (std::hash<int>()(p.second) << 1);
+    }
+};
+
+static void bench_chunk_map() {
+    // a 33x33 chunk area (render distance 16) away from the origin,
+    // looked up in a scattered order with about 1 miss in 10
+    const int radius = 16;
+    const int side = radius * 2 + 1;
+    const int centerX = 1000, centerZ = -700;
+    const int lookups = 1 << 16;
+    const int iterations = 200;
+
+    std::vector<std::pair<int, int>> keys;
+    for (int dz = -radius; dz <= radius; ++dz)
+        for (int dx = -radius; dx <= radius; ++dx)
+            keys.push_back({ centerX + dx, centerZ + dz });
+
+    std::vector<std::pair<int, int>> queries(lookups);
+    uint64_t state = BENCH_SEED;
+    for (auto& query : queries) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        int range = side + 2; // one ring outside the area
+        query = { centerX - radius - 1 + int((state >> 33) % range), centerZ - radius - 1 + int((state >> 45) % range) };
+    }
+
+    std::unordered_map<std::pair<int, int>, int, XorPairHash> baseline;
+    ChunkMap<int> flat;
+    long baselineSum = 0, flatSum = 0;
+
+    double baselineInsertUs = time_per_call_us(iterations, [&]() {
+        baseline.clear();
+        for (size_t i = 0; i < keys.size(); ++i) baseline[keys[i]] = int(i);
+    });
+    double flatInsertUs = time_per_call_us(iterations, [&]() {
+        flat.clear();
+        for (size_t i = 0; i < keys.size(); ++i) flat[keys[i]] = int(i);
+    });
+
+    double baselineLookupUs = time_per_call_us(iterations, [&]() {
+        for (const auto& query : queries) {
+            auto it = baseline.find(query);
+            if (it != baseline.end()) baselineSum += it->second;
+        }
+    });
+    double flatLookupUs = time_per_call_us(iterations, [&]() {
+        for (const auto& query : queries) {
+            const int* value = flat.find(query.first, query.second);
+            if (value) flatSum += *value;
+        }
+    });
+
+    double baselineIterateUs = time_per_call_us(iterations * 10, [&]() {
+        for (const auto& [pos, value] : baseline) baselineSum += value;
+    });
+    double flatIterateUs = time_per_call_us(iterations * 10, [&]() {
+        for (const auto& [pos, value] : flat) flatSum += value;
+    });
+
+    auto row = [](const char* name, double baselineUs, double flatUs, int count) {
+        std::cout << "  " << std::left << std::setw(8) << name << std::right
+                  << " unordered_map " << std::setw(7) << baselineUs * 1000.0 / count << " ns"
+                  << "   flat " << std::setw(7) << flatUs * 1000.0 / count << " ns"
+                  << "   speedup " << std::setw(5) << baselineUs / flatUs << "x\n";
+    };
+    std::cout << "Chunk map (" << keys.size() << " chunks, per operation)\n" << std::fixed << std::setprecision(2);
+    row("insert", baselineInsertUs, flatInsertUs, int(keys.size()));
+    row("lookup", baselineLookupUs, flatLookupUs, lookups);
+    row("iterate", baselineIterateUs, flatIterateUs, int(keys.size()));
+    if (baselineSum != flatSum)
+        std::cout << "  MISMATCH between the maps\n";
+}
+
+int run_benchmarks() {
+    bool generationOk = check_generation();
+    bench_noise();
+    bench_chunk_size();
+    bench_chunk_map();
+
+    std::cout << "Visible face culling (" << CHUNK_SIZE << "x" << CHUNK_HEIGHT << "x" << CHUNK_SIZE << " chunk)\n";
+
+    ChunkGrid terrain;
+    make_terrain_grid(terrain, 0, 0);
+    bench_face_culling("terrain", terrain);
+
+    ChunkGrid checkerboard;
+    make_checkerboard_grid(checkerboard);
+    bench_face_culling("checkerboard", checkerboard);
+
+    // empty and uniform sections cost no block storage
+    const char* kindNames[] = { "empty", "uniform", "mixed" };
+    size_t totalBytes = 0;
+    std::cout << "Block storage (terrain chunk, " << SECTION_COUNT << " sections of " << SECTION_HEIGHT << ")\n";
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        const ChunkSection& blocks = terrain.center()->get_section(section);
+        totalBytes += blocks.memory_bytes();
+        std::cout << "  y " << std::setw(3) << section * SECTION_HEIGHT << " " << std::left << std::setw(8)
+                  << kindNames[blocks.kind()] << std::right << std::setw(5) << blocks.memory_bytes() << " bytes";
+        if (const BlockStorage* storage = blocks.get_storage())
+            std::cout << ", " << storage->get_palette().size() << " palette entries at "
+                      << storage->bits_per_block() << " bits per block";
+        std::cout << "\n";
+    }
+    std::cout << "  total " << totalBytes << " bytes   unpacked "
+              << CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE * sizeof(Block) << " bytes\n";
+
+    return generationOk ? 0 : 1;
+}
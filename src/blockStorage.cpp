@@ -0,0 +1,84 @@
+#include "blockStorage.hpp"
+
+BlockStorage::BlockStorage(int size) : count(size) {
+    palette.push_back(BLOCK_AIR);
+    words.assign((size + 63) / 64, 0);
+}
+
+int BlockStorage::palette_index(BlockID id) const {
+    // palettes hold a handful of entries, a linear scan beats a map
+    for (size_t i = 0; i < palette.size(); ++i)
+        if (palette[i] == id) return int(i);
+    return -1;
+}
+
+void BlockStorage::write(int index, uint64_t entry) {
+    uint64_t& word = words[index >> (6 - bitsLog2)];
+    int offset = (index & ((64 >> bitsLog2) - 1)) << bitsLog2;
+    word = (word & ~(mask << offset)) | (entry << offset);
+}
+
+void BlockStorage::set(int index, BlockID id) {
+    int entry = palette_index(id);
+    if (entry == -1) {
+        // palette full at this width, double the bits per block
+        if (palette.size() == (size_t(1) << bits_per_block()))
+            grow();
+        palette.push_back(id);
+        entry = int(palette.size()) - 1;
+    }
+    write(index, uint64_t(entry));
+}
+
+void BlockStorage::assign(const BlockID* ids) {
+    // palette in order of first appearance, then packed at the smallest width
+    int entryOf[BLOCK_COUNT];
+    for (int i = 0; i < BLOCK_COUNT; ++i) entryOf[i] = -1;
+
+    palette.clear();
+    for (int i = 0; i < count; ++i) {
+        if (entryOf[ids[i]] == -1) {
+            entryOf[ids[i]] = int(palette.size());
+            palette.push_back(ids[i]);
+        }
+    }
+
+    bitsLog2 = 0;
+    while (palette.size() > (size_t(1) << bits_per_block()))
+        bitsLog2++;
+    mask = (uint64_t(1) << bits_per_block()) - 1;
+    int perWord = 64 >> bitsLog2;
+    words.assign((count + perWord - 1) / perWord, 0);
+
+    for (int i = 0; i < count; ++i)
+        write(i, uint64_t(entryOf[ids[i]]));
+}
+
+void BlockStorage::grow() {
+    // repacks every index at twice the width
+    std::vector<uint8_t> indices(count);
+    unpack(indices.data());
+
+    bitsLog2++;
+    mask = (uint64_t(1) << bits_per_block()) - 1;
+    int perWord = 64 >> bitsLog2;
+    words.assign((count + perWord - 1) / perWord, 0);
+
+    for (int i = 0; i < count; ++i)
+        write(i, indices[i]);
+}
+
+void BlockStorage::unpack(uint8_t* out) const {
+    // a whole word at a time instead of one shift and mask per get()
+    int bits = bits_per_block();
+    int perWord = 64 >> bitsLog2;
+    int i = 0;
+    for (uint64_t word : words) {
+        for (int k = 0; k < perWord && i < count; ++k, word >>= bits)
+            out[i++] = uint8_t(word & mask);
+    }
+}
+
+size_t BlockStorage::memory_bytes() const {
+    return words.size() * sizeof(uint64_t) + palette.size() * sizeof(BlockID);
+}
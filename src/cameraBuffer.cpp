@@ -0,0 +1,25 @@
+#include "cameraBuffer.hpp"
+
+CameraBuffer::CameraBuffer() {
+    glGenBuffers(1, &ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // binding points aren't program state, this holds for every program attached
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, ID);
+}
+
+void CameraBuffer::attach(Shader& shader) {
+    shader.set_block_binding("Camera", BINDING);
+}
+
+void CameraBuffer::update(const CameraData& data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void CameraBuffer::free() {
+    glDeleteBuffers(1, &ID);
+}
@@ -16,6 +16,12 @@ Camera::Camera(float width, float height) {
     firstMouse = true;
     wireframe = false;
     tabLastFrame = false;
+    greedyMeshing = true;
+    gLastFrame = false;
+    batchedDrawing = true;
+    bLastFrame = false;
+    occlusionCulling = true;
+    oLastFrame = false;
     currBlock = BLOCK_GRASS;
 }
 
@@ -99,6 +105,24 @@ void Camera::process_keyboard(GLFWwindow* window, float deltaTime) {
     if (tabThisFrame && !tabLastFrame)
         toggle_polygon();
     tabLastFrame = tabThisFrame;
+
+    // toggle greedy meshing to compare triangle counts
+    bool gThisFrame = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+    if (gThisFrame && !gLastFrame)
+        greedyMeshing = !greedyMeshing;
+    gLastFrame = gThisFrame;
+
+    // toggle multi-draw batching to compare draw calls and submission time
+    bool bThisFrame = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+    if (bThisFrame && !bLastFrame)
+        batchedDrawing = !batchedDrawing;
+    bLastFrame = bThisFrame;
+
+    // toggle occlusion culling to compare drawn triangles
+    bool oThisFrame = glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS;
+    if (oThisFrame && !oLastFrame)
+        occlusionCulling = !occlusionCulling;
+    oLastFrame = oThisFrame;
 }
 
 void Camera::process_mouse(float xoffset, float yoffset) {
@@ -113,6 +137,13 @@ void Camera::process_mouse(float xoffset, float yoffset) {
     update();
 }
 
+void Camera::set_view(const glm::vec3& pos, float newYaw, float newPitch) {
+    position = pos;
+    yaw = newYaw;
+    pitch = newPitch;
+    update();
+}
+
 void Camera::toggle_polygon() {
     // toggles between GL_LINE and GL_FILL for debug
     wireframe = !wireframe;
@@ -1,25 +1,23 @@
 #include "chunk.hpp"
+#include "worldGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 Chunk::Chunk(int x, int z) : chunkX(x), chunkZ(z) {
-    blocks.resize(CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE);
+    for (int section = 0; section < SECTION_COUNT; ++section)
+        sections.emplace_back(SECTION_VOLUME);
+    solidColumns.resize(SECTION_COUNT * CHUNK_SIZE * CHUNK_SIZE, 0);
     treesGenerated = false;
-    generate_blocks();
 }
 
 Chunk::~Chunk() {
-    vao.free();
-    if (vbo) {
-        vbo->free();
-        delete vbo;
-    }
-    if (ebo) {
-        ebo->free();
-        delete ebo;
-    }
+    if (meshArena)
+        meshArena->release(meshRange);
 }
 
 int Chunk::get_index(int x, int y, int z) const {
-    // returns block index in blocks array from chunk coords
+    // returns block index in its section from chunk coords
     if(x < 0 || x >= CHUNK_SIZE) {
         return -1;
     }
@@ -32,7 +30,18 @@ int Chunk::get_index(int x, int y, int z) const {
         return -1;
     }
 
-    return x + y * CHUNK_SIZE + z * CHUNK_SIZE * CHUNK_HEIGHT;
+    return ChunkDims::section_index(x, y & (SECTION_HEIGHT - 1), z);
+}
+
+const ChunkSection& Chunk::get_section(int section) const {
+    return sections[section];
+}
+
+size_t Chunk::memory_bytes() const {
+    size_t bytes = solidColumns.size() * sizeof(ColumnMask);
+    for (const ChunkSection& section : sections)
+        bytes += section.memory_bytes();
+    return bytes;
 }
 
 Block Chunk::get_block(int x, int y, int z) const {
@@ -40,152 +49,157 @@ Block Chunk::get_block(int x, int y, int z) const {
     int index = get_index(x, y, z);
     if(index == -1)
         return BLOCK_AIR;
-    return blocks[index];
+    return sections[y >> ChunkDims::SECTION_LOG2].get(index);
 }
 
 void Chunk::set_block(int x, int y, int z, Block block) {
     int index = get_index(x, y, z);
     if(index == -1) return;
-    blocks[index] = block;
-}
-
-void Chunk::set_block_safe(int x, int y, int z, Block block, Chunk* left, Chunk* right, Chunk* front, Chunk* back) {
-    if (y < 0 || y >= CHUNK_HEIGHT) return;
-    if (x >= 0 && x < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) {
-        this->set_block(x, y, z, block);
-    } else if (x < 0 && left) {
-        left->set_block(x + CHUNK_SIZE, y, z, block);
-    } else if (x >= CHUNK_SIZE && right) {
-        right->set_block(x - CHUNK_SIZE, y, z, block);
-    } else if (z < 0 && back) {
-        back->set_block(x, y, z + CHUNK_SIZE, block);
-    } else if (z >= CHUNK_SIZE && front) {
-        front->set_block(x, y, z - CHUNK_SIZE, block);
-    }
+    int section = y >> ChunkDims::SECTION_LOG2;
+    sections[section].set(index, block.ID);
+
+    // keep the column occupancy in sync
+    ColumnMask bit = ColumnMask(1) << (y & (SECTION_HEIGHT - 1));
+    ColumnMask& column = solidColumns[x + z * CHUNK_SIZE + section * CHUNK_SIZE * CHUNK_SIZE];
+    if (block.is_solid())
+        column |= bit;
+    else
+        column &= ~bit;
 }
 
-float Chunk::octave_noise(float x, float z, FastNoiseLite& noise) {
-    float total = 0.0f;
-    float amplitude = 1.0f;
-    float frequency = 1.0f;
-    float maxValue = 0.0f;
-
-    for (int i = 0; i < 4; ++i) {
-        total += noise.GetNoise(x * frequency, z * frequency) * amplitude;
-        maxValue += amplitude;
-        amplitude *= 0.5f;
-        frequency *= 2.0f;
-    }
-
-    return total / maxValue;
-}
+static const int SEA_LEVEL = 8;
 
-void Chunk::generate_blocks() {
+void Chunk::generate_blocks(WorldGenerator& generator) {
     // chunk generation
-    static int seed = std::rand();
-    FastNoiseLite noise;
-    noise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    noise.SetFrequency(0.01f);
-    noise.SetSeed(seed);
+    std::shared_ptr<const ColumnHeights> heights = generator.get_heights(chunkX, chunkZ);
 
-    const float baseFrequency = 0.5f;
-    const int SEA_LEVEL = 8;
+    // filled locally and packed once per section, set_block would repack as the palette grows
+    std::vector<BlockID> ids(SECTION_COUNT * SECTION_VOLUME, BLOCK_AIR);
+    auto place = [&](int x, int y, int z, BlockID id) {
+        ids[(y >> ChunkDims::SECTION_LOG2) * SECTION_VOLUME + get_index(x, y, z)] = id;
+    };
 
     for (int x = 0; x < CHUNK_SIZE; ++x) {
         for (int z = 0; z < CHUNK_SIZE; ++z) {
-            int worldX = chunkX * CHUNK_SIZE + x;
-            int worldZ = chunkZ * CHUNK_SIZE + z;
-
-            float heightNoise = octave_noise(worldX * baseFrequency, worldZ * baseFrequency, noise);
-            int height = (int)((heightNoise + 1.0f) * 0.5f * (CHUNK_HEIGHT - 1));
+            int height = heights->at(x, z);
             
             for (int y = 0; y < CHUNK_HEIGHT; ++y) {
                 if (y > height)
-                    set_block(x, y, z, BLOCK_AIR);
+                    place(x, y, z, BLOCK_AIR);
                 else if (y == height){
                     if (y <= SEA_LEVEL)
-                        set_block(x, y, z, BLOCK_SAND);
+                        place(x, y, z, BLOCK_SAND);
                     else
-                        set_block(x, y, z, BLOCK_GRASS);
+                        place(x, y, z, BLOCK_GRASS);
                 }
                 else if (y == 0) {
-                    set_block(x, y, z, BLOCK_BEDROCK);
+                    place(x, y, z, BLOCK_BEDROCK);
                 }
                 else if (y > height - 3)
-                    set_block(x, y, z, BLOCK_DIRT);
+                    place(x, y, z, BLOCK_DIRT);
                 else
-                    set_block(x, y, z, BLOCK_STONE); 
+                    place(x, y, z, BLOCK_STONE); 
+            }
+        }
+    }
+
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        const BlockID* sectionIds = &ids[section * SECTION_VOLUME];
+        sections[section].assign(sectionIds);
+
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                ColumnMask column = 0;
+                for (int y = 0; y < SECTION_HEIGHT; ++y)
+                    if (Block(sectionIds[ChunkDims::section_index(x, y, z)]).is_solid())
+                        column |= ColumnMask(1) << y;
+                solidColumns[x + z * CHUNK_SIZE + section * CHUNK_SIZE * CHUNK_SIZE] = column;
             }
         }
     }
 }
 
-void Chunk::generate_trees(Chunk* left, Chunk* right, Chunk* front, Chunk* back) {
+void Chunk::generate_trees(WorldGenerator& generator) {
+    // places the trees of this chunk and of the 8 around it (leaves reach
+    // 3 blocks out), blocks outside this chunk are dropped by set_block.
+    // the neighbors place their own part, so no chunk writes another one
     if (treesGenerated) return;
 
     treesGenerated = true;
-    static int seed = std::rand();
-    FastNoiseLite treeNoise;
-    treeNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
-    treeNoise.SetFrequency(4.0f);
-    treeNoise.SetSeed(seed + 5000);
-
-    for (int x = 1; x < CHUNK_SIZE - 1; ++x) {
-        for (int z = 1; z < CHUNK_SIZE - 1; ++z) {
-            int worldX = chunkX * CHUNK_SIZE + x;
-            int worldZ = chunkZ * CHUNK_SIZE + z;
-
-            float treeChance = treeNoise.GetNoise((float)worldX, (float)worldZ);
-            if (treeChance > 0.92f) {
-                // find surface block below limit -10 (max tree size)
-                for (int y = CHUNK_HEIGHT - 10; y >= 1; --y) {
-                    Block current = get_block(x, y, z);
-                    // found surface block
-                    if (current.ID == BLOCK_GRASS) {
-                        // change it to dirt
-                        set_block(x, y, z, BLOCK_DIRT);
+
+    // same order in every chunk, so overlapping trees resolve the same way
+    for (int ownerX = chunkX - 1; ownerX <= chunkX + 1; ++ownerX) {
+        for (int ownerZ = chunkZ - 1; ownerZ <= chunkZ + 1; ++ownerZ) {
+            ChunkRandom random(generator.get_seed(), ownerX, ownerZ, FEATURE_TREES);
+            std::shared_ptr<const ColumnHeights> heights;
+
+            for (int x = 1; x < CHUNK_SIZE - 1; ++x) {
+                for (int z = 1; z < CHUNK_SIZE - 1; ++z) {
+                    int worldX = ownerX * CHUNK_SIZE + x;
+                    int worldZ = ownerZ * CHUNK_SIZE + z;
+
+                    // trees too far to put a leaf in this chunk don't need the noise
+                    int localX = worldX - chunkX * CHUNK_SIZE;
+                    int localZ = worldZ - chunkZ * CHUNK_SIZE;
+                    if (localX < -TREE_REACH || localX >= CHUNK_SIZE + TREE_REACH ||
+                        localZ < -TREE_REACH || localZ >= CHUNK_SIZE + TREE_REACH) continue;
+
+                    float treeChance = generator.tree_chance(worldX, worldZ);
+                    if (treeChance <= 0.92f) continue;
+
+                    // trees grow on grass, below limit -10 (max tree size)
+                    if (!heights) heights = generator.get_heights(ownerX, ownerZ);
+                    int y = heights->at(x, z);
+                    if (y <= SEA_LEVEL || y > CHUNK_HEIGHT - 10) continue;
+
+                    // every column has its own range of random values
+                    random.seek(uint64_t(x + z * CHUNK_SIZE) << 16);
+                    place_tree(localX, y, localZ, random);
+                }
+            }
+        }
+    }
+}
+
+void Chunk::place_tree(int x, int y, int z, ChunkRandom& random) {
+    // x, z in this chunk's coords, can be outside of it
+    // change surface block to dirt
+    set_block(x, y, z, BLOCK_DIRT);
+
+    // trunk height between 4 - 7
+    int trunkHeight = 4 + random.next_int(4);
+
+    // place trunk
+    for (int h = 1; h <= trunkHeight; ++h) {
+        int blockY = y + h;
+        if (blockY >= 0 && blockY < CHUNK_HEIGHT) {
+            set_block(x, blockY, z, BLOCK_LOG);
+        }
+    }
+    // leafType (1 or 2)
+    Block leafType;
+    random.next_int(2) == 0? leafType = BLOCK_PINK_LEAVES : leafType = BLOCK_ORANGE_LEAVES;
+    // leaves center
+    int leafCenterY = y + trunkHeight;
+
+    // leaves sphere radius
+    int radius = TREE_REACH;
+
+    for (int dy = -radius; dy <= radius; ++dy) {
+        int blockY = leafCenterY + dy;
+        if (blockY < 0 || blockY >= CHUNK_HEIGHT) continue;
+        for (int dx = -radius; dx <= radius; ++dx) {
+            for (int dz = -radius; dz <= radius; ++dz) {
+                float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+                if (dist <= radius) {
+                    if (dx == 0 && dz == 0 && blockY >= y && blockY <= y + trunkHeight)
+                        continue;
+                    if(blockY == leafCenterY) continue;
+                    // skip random leaves (avoid perfect sphere)
+                    if (random.next_int(100) < 75) { // 25% to skip leaf
                         
-                        // trunk height between 4 - 7
-                        int trunkHeight = 4 + std::rand() % 4;
-
-                        // place trunk
-                        for (int h = 1; h <= trunkHeight; ++h) {
-                            int blockY = y + h;
-                            if (blockY >= 0 && blockY < CHUNK_HEIGHT) {
-                                set_block_safe(x, blockY, z, BLOCK_LOG, left, right, front, back);
-                            }
-                        }
-                        // leafType (1 or 2)
-                        Block leafType;
-                        rand() % 2 == 0? leafType = BLOCK_PINK_LEAVES : leafType = BLOCK_ORANGE_LEAVES;
-                        // leaves center
-                        int leafCenterY = y + trunkHeight;
-
-                        // leaves sphere radius
-                        int radius = 3;
-
-                        for (int dy = -radius; dy <= radius; ++dy) {
-                            int blockY = leafCenterY + dy;
-                            if (blockY < 0 || blockY >= CHUNK_HEIGHT) continue;
-                            for (int dx = -radius; dx <= radius; ++dx) {
-                                for (int dz = -radius; dz <= radius; ++dz) {
-                                    float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
-
-                                    if (dist <= radius) {
-                                        if (dx == 0 && dz == 0 && blockY >= y && blockY <= y + trunkHeight)
-                                            continue;
-                                        if(blockY == leafCenterY) continue;
-                                        // skip random leaves (avoid perfect sphere)
-                                        if (std::rand() % 100 < 75) { // 25% to skip leaf
-                                            
-                                            set_block_safe(x + dx, leafCenterY + dy, z + dz, leafType, left, right, front, back);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        // tree placed, stop looking for surface block
-                        break;
+                        set_block(x + dx, leafCenterY + dy, z + dz, leafType);
                     }
                 }
             }
@@ -193,39 +207,102 @@ void Chunk::generate_trees(Chunk* left, Chunk* right, Chunk* front, Chunk* back)
     }
 }
 
-int Chunk::get_ao(bool side1, bool side2, bool corner) {
+int Chunk::get_ao(bool side1, bool side2, bool corner) const {
     if (side1 && side2) return 0;
     return 3 - (int(side1) + int(side2) + int(corner));
 }
 
-bool Chunk::is_block_solid_at(int x, int y, int z, Chunk* left, Chunk* right, Chunk* front, Chunk* back) const {
-    if (x < 0) {
-        if (!left) return false;
-        return left->get_block(CHUNK_SIZE - 1, y, z).is_solid();
-    }
-    if (x >= CHUNK_SIZE) {
-        if (!right) return false;
-        return right->get_block(0, y, z).is_solid();
-    }
-    if (z < 0) {
-        if (!back) return false;
-        return back->get_block(x, y, CHUNK_SIZE - 1).is_solid();
-    }
-    if (z >= CHUNK_SIZE) {
-        if (!front) return false;
-        return front->get_block(x, y, 0).is_solid();
-    }
-    if (y < 0 || y >= CHUNK_HEIGHT) return false;
+ColumnMask Chunk::get_solid_column(int section, int x, int z) const {
+    return solidColumns[x + z * CHUNK_SIZE + section * CHUNK_SIZE * CHUNK_SIZE];
+}
+
+bool Chunk::is_section_empty(int section) const {
+    // no solid block, whatever the section stores
+    for (int column = 0; column < CHUNK_SIZE * CHUNK_SIZE; ++column)
+        if (solidColumns[column + section * CHUNK_SIZE * CHUNK_SIZE]) return false;
+    return true;
+}
 
-    return get_block(x, y, z).is_solid();
+bool Chunk::is_section_opaque(int section) const {
+    // every level of every column solid, the top section only has the levels below CHUNK_HEIGHT
+    int levels = std::min(SECTION_HEIGHT, CHUNK_HEIGHT - section * SECTION_HEIGHT);
+    ColumnMask full = (ColumnMask(1) << levels) - 1;
+    for (int column = 0; column < CHUNK_SIZE * CHUNK_SIZE; ++column)
+        if (solidColumns[column + section * CHUNK_SIZE * CHUNK_SIZE] != full) return false;
+    return true;
 }
 
+bool Chunk::can_skip_section(const ChunkNeighborhood& neighbors, int section) const {
+    // sections without any visible face: no solid block, or solid all through
+    // and covered by solid sections on all six sides (outside the world is air)
+    if (is_section_empty(section)) return true;
+    if (!is_section_opaque(section)) return false;
+    if (section == 0 || !is_section_opaque(section - 1)) return false;
+    if (section == SECTION_COUNT - 1 || !is_section_opaque(section + 1)) return false;
+
+    for (Chunk* neighbor : { neighbors.left(), neighbors.right(), neighbors.front(), neighbors.back() })
+        if (!neighbor || !neighbor->is_section_opaque(section)) return false;
+    return true;
+}
 
-void Chunk::build_mesh(Chunk* left, Chunk* right, Chunk* front, Chunk* back) {
-    // constructs chunk's vao, vbo and ebo
-    vertices.clear();
-    indices.clear();
-    GLuint indexOffset = 0;
+void Chunk::fill_apron(const ChunkNeighborhood& neighbors, int section, ChunkApron& apron) const {
+    // copies the solidity of a section and a one block border around it,
+    // missing neighbor chunks and the levels outside the world count as air
+    for (int pz = 0; pz < ChunkApron::SIZE; ++pz) {
+        for (int px = 0; px < ChunkApron::SIZE; ++px) {
+            int x = px - 1;
+            int z = pz - 1;
+            int dx = x < 0 ? -1 : (x >= CHUNK_SIZE ? 1 : 0);
+            int dz = z < 0 ? -1 : (z >= CHUNK_SIZE ? 1 : 0);
+
+            const Chunk* chunk = (dx == 0 && dz == 0) ? this : neighbors.at(dx, dz);
+            ColumnMask column = 0;
+            if (chunk) {
+                int localX = x - dx * CHUNK_SIZE;
+                int localZ = z - dz * CHUNK_SIZE;
+                // the section shifted up one bit, with the top level of the
+                // section below in bit 0 and the bottom one of the section above
+                column = chunk->get_solid_column(section, localX, localZ) << 1;
+                if (section > 0)
+                    column |= (chunk->get_solid_column(section - 1, localX, localZ) >> (SECTION_HEIGHT - 1)) & 1;
+                if (section < SECTION_COUNT - 1)
+                    column |= (chunk->get_solid_column(section + 1, localX, localZ) & 1) << (SECTION_HEIGHT + 1);
+            }
+
+            apron.columns[px + pz * ChunkApron::SIZE] = column;
+            for (int py = 0; py < ChunkApron::HEIGHT; ++py)
+                apron.solid[ChunkApron::index(x, py - 1, z)] = (column >> py) & 1;
+        }
+    }
+}
+
+void Chunk::find_visible_faces(const ChunkApron& apron, ColumnMask visible[6][CHUNK_SIZE * CHUNK_SIZE]) const {
+    // visible faces of a whole section column at once: solid bits whose neighbor bit
+    // (next column, or the column shifted by one for up/down) is not solid.
+    // apron columns start one level below the section, results start at its bottom
+    const ColumnMask inside = ((ColumnMask(1) << SECTION_HEIGHT) - 1) << 1;
+
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            int column = x + z * CHUNK_SIZE;
+            ColumnMask withBorder = apron.column(x, z);
+            ColumnMask solid = withBorder & inside;
+
+            visible[0][column] = (solid & ~apron.column(x, z - 1)) >> 1; // -Z
+            visible[1][column] = (solid & ~apron.column(x, z + 1)) >> 1; // +Z
+            visible[2][column] = (solid & ~apron.column(x - 1, z)) >> 1; // -X
+            visible[3][column] = (solid & ~apron.column(x + 1, z)) >> 1; // +X
+            visible[4][column] = (solid & ~(withBorder << 1)) >> 1;      // -Y
+            visible[5][column] = (solid & ~(withBorder >> 1)) >> 1;      // +Y
+        }
+    }
+}
+
+ChunkMeshData Chunk::build_mesh(const ChunkNeighborhood& neighbors, bool greedy) const {
+    // builds chunk's vertices (CPU only, safe to run off the main thread)
+    // greedy mode merges coplanar faces with the same tile and flat AO into bigger quads
+    ChunkMeshData mesh;
+    std::vector<uint32_t>& vertices = mesh.vertices;
 
     const GLfloat faceVertices[6][20] = {
         // -Z
@@ -260,15 +337,6 @@ void Chunk::build_mesh(Chunk* left, Chunk* right, Chunk* front, Chunk* back) {
          -0.5f, 0.5f,  -0.5f, 0.0f, 1.0f }
     };
 
-    const int neighborOffsets[6][3] = {
-        {  0,  0, -1 }, // -Z
-        {  0,  0,  1 }, // +Z
-        { -1,  0,  0 }, // -X
-        {  1,  0,  0 }, // +X
-        {  0, -1,  0 }, // -Y
-        {  0,  1,  0 }  // +Y
-    };
-
     // hardcoded blocks that each vertex has to check to calculate AO
     // format: 6 Faces --> 4 Vertex --> 3 Blocks to calculate --> X, Y, Z
     //                                   - side 1
@@ -312,121 +380,203 @@ void Chunk::build_mesh(Chunk* left, Chunk* right, Chunk* front, Chunk* back) {
         {{-1, 1, 0}, { 0, 1,-1}, {-1, 1,-1}}}  // v3 
     };
 
-    const int atlasW = 4;
-    const int atlasH = 2;
+    // Add a quad covering ext[0] x ext[1] x ext[2] blocks from start (chunk coords)
+    auto emit_quad = [&](int face, const int start[3], const int ext[3], uint32_t key) {
+        const GLfloat* corners = faceVertices[face];
+        int tile = int(key & 0xFF) - 1;
 
-    for (int x = 0; x < CHUNK_SIZE; ++x) {
-        for (int y = 0; y < CHUNK_HEIGHT; ++y) {
-            for (int z = 0; z < CHUNK_SIZE; ++z) {
-                const Block& block = get_block(x, y, z);
-                if (!block.is_solid()) continue;
-
-                float fx = float(x + chunkX * CHUNK_SIZE);
-                float fy = float(y);
-                float fz = float(z + chunkZ * CHUNK_SIZE);
-
-                // face skipping depending on neighbor blocks
-                for (int face = 0; face < 6; ++face) {
-                    int nx = x + neighborOffsets[face][0];
-                    int ny = y + neighborOffsets[face][1];
-                    int nz = z + neighborOffsets[face][2];
-
-                    bool drawFace = false;
-
-                    switch (face) {
-                        case 0: drawFace = (z == 0) ? !back || !back->get_block(x, y, CHUNK_SIZE - 1).is_solid() : !get_block(x, y, z - 1).is_solid(); break;
-                        case 1: drawFace = (z == CHUNK_SIZE - 1) ? !front || !front->get_block(x, y, 0).is_solid() : !get_block(x, y, z + 1).is_solid(); break;
-                        case 2: drawFace = (x == 0) ? !left || !left->get_block(CHUNK_SIZE - 1, y, z).is_solid() : !get_block(x - 1, y, z).is_solid(); break;
-                        case 3: drawFace = (x == CHUNK_SIZE - 1) ? !right || !right->get_block(0, y, z).is_solid() : !get_block(x + 1, y, z).is_solid(); break;
-                        case 4: drawFace = (y == 0) ? true : !get_block(x, y - 1, z).is_solid(); break;
-                        case 5: drawFace = (y == CHUNK_HEIGHT - 1) ? true : !get_block(x, y + 1, z).is_solid(); break;
-                    }
+        for (int i = 0; i < 4; ++i) {
+            int base = i * 5;
 
-                    if (!drawFace) continue;
+            // stretch the unit face corners over the quad extent,
+            // block corners in chunk coords (the shader adds the chunk origin)
+            int corner[3];
+            for (int axis = 0; axis < 3; ++axis)
+                corner[axis] = start[axis] + (corners[base + axis] > 0.0f ? ext[axis] : 0);
 
-                    int tileIndex = block.get_texture_index();
-                    int tileX = tileIndex % atlasW;
-                    int tileY = tileIndex / atlasW;
+            int ao = (key >> (8 + 2 * i)) & 3;
+            mesh.minY = vertices.empty() ? corner[1] : std::min(mesh.minY, corner[1]);
+            mesh.maxY = vertices.empty() ? corner[1] : std::max(mesh.maxY, corner[1]);
+            vertices.push_back(pack_vertex(corner[0], corner[1], corner[2], face, ao, tile));
+        }
+    };
 
-                    float uvW = 1.0f / float(atlasW);
-                    float uvH = 1.0f / float(atlasH);
-                    float uMin = tileX * uvW;
-                    float vMin = tileY * uvH;
+    // visible faces of a section, one key per face direction and block (0 = hidden)
+    // key format: tile + 1 (bits 0-7), AO of v0..v3 (2 bits each, from bit 8)
+    std::vector<uint32_t> faceKeys(6 * SECTION_VOLUME);
+    ChunkApron apron;
+    ColumnMask visible[6][CHUNK_SIZE * CHUNK_SIZE];
+    uint8_t paletteIndices[SECTION_VOLUME];
+    std::vector<uint32_t> paletteKeys;
+
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        // empty and buried sections have no visible face
+        if (can_skip_section(neighbors, section)) continue;
+
+        int baseY = section * SECTION_HEIGHT;
+        int levels = std::min(SECTION_HEIGHT, CHUNK_HEIGHT - baseY);
+
+        // solidity of the section and its border, all reads below are plain lookups
+        fill_apron(neighbors, section, apron);
+        find_visible_faces(apron, visible);
+
+        // atlas tile of every block, through the palette instead of a get_block per face
+        const ChunkSection& blockSection = sections[section];
+        paletteKeys.clear();
+        if (const BlockStorage* storage = blockSection.get_storage()) {
+            storage->unpack(paletteIndices);
+            for (BlockID id : storage->get_palette())
+                paletteKeys.push_back(uint32_t(Block(id).get_texture_index() + 1));
+        } else {
+            std::memset(paletteIndices, 0, sizeof(paletteIndices));
+            paletteKeys.push_back(uint32_t(Block(blockSection.get_uniform()).get_texture_index() + 1));
+        }
 
-                    // Add face vertices (with offset) adjusting atlas UV + AO calculation by offsets
-                    for (int i = 0; i < 4; ++i) {
-                        int base = i * 5;
+        std::fill(faceKeys.begin(), faceKeys.end(), 0);
 
-                        float vx = faceVertices[face][base + 0] + fx;
-                        float vy = faceVertices[face][base + 1] + fy;
-                        float vz = faceVertices[face][base + 2] + fz;
+        for (int face = 0; face < 6; ++face) {
+            for (int z = 0; z < CHUNK_SIZE; ++z) {
+                for (int x = 0; x < CHUNK_SIZE; ++x) {
+                    ColumnMask bits = visible[face][x + z * CHUNK_SIZE];
 
-                        float rawU = faceVertices[face][base + 3];
-                        float rawV = faceVertices[face][base + 4];
+                    // one visible face per set bit, y in section coords
+                    while (bits) {
+                        int y = lowest_bit(bits);
+                        bits &= bits - 1;
 
-                        float u = uMin + rawU * uvW;
-                        float v = (1.0f - (tileY + 1) * uvH) + rawV * uvH;
+                        int index = get_index(x, y, z);
+                        uint32_t key = paletteKeys[paletteIndices[index]];
 
-                        // neighbor AOs
-                        int ao1x = x + aoOffsets[face][i][0][0];
-                        int ao1y = y + aoOffsets[face][i][0][1];
-                        int ao1z = z + aoOffsets[face][i][0][2];
+                        // AO calculation by offsets
+                        for (int i = 0; i < 4; ++i) {
+                            int ao1x = x + aoOffsets[face][i][0][0];
+                            int ao1y = y + aoOffsets[face][i][0][1];
+                            int ao1z = z + aoOffsets[face][i][0][2];
 
-                        int ao2x = x + aoOffsets[face][i][1][0];
-                        int ao2y = y + aoOffsets[face][i][1][1];
-                        int ao2z = z + aoOffsets[face][i][1][2];
+                            int ao2x = x + aoOffsets[face][i][1][0];
+                            int ao2y = y + aoOffsets[face][i][1][1];
+                            int ao2z = z + aoOffsets[face][i][1][2];
 
-                        int ao3x = x + aoOffsets[face][i][2][0];
-                        int ao3y = y + aoOffsets[face][i][2][1];
-                        int ao3z = z + aoOffsets[face][i][2][2];
+                            int ao3x = x + aoOffsets[face][i][2][0];
+                            int ao3y = y + aoOffsets[face][i][2][1];
+                            int ao3z = z + aoOffsets[face][i][2][2];
 
-                        bool s1 = is_block_solid_at(ao1x, ao1y, ao1z, left, right, front, back);
-                        bool s2 = is_block_solid_at(ao2x, ao2y, ao2z, left, right, front, back);
-                        bool c  = is_block_solid_at(ao3x, ao3y, ao3z, left, right, front, back);
+                            bool s1 = apron.is_solid(ao1x, ao1y, ao1z);
+                            bool s2 = apron.is_solid(ao2x, ao2y, ao2z);
+                            bool c  = apron.is_solid(ao3x, ao3y, ao3z);
 
-                        float ao = get_ao(s1, s2, c) / 3.0f;
+                            key |= uint32_t(get_ao(s1, s2, c)) << (8 + 2 * i);
+                        }
 
-                        vertices.push_back(vx);
-                        vertices.push_back(vy);
-                        vertices.push_back(vz);
-                        vertices.push_back(u);
-                        vertices.push_back(v);
-                        vertices.push_back(ao);
+                        faceKeys[face * SECTION_VOLUME + index] = key;
+                        mesh.faceCount++;
                     }
+                }
+            }
+        }
+
+        const int dims[3] = { CHUNK_SIZE, levels, CHUNK_SIZE };
+
+        for (int face = 0; face < 6; ++face) {
+            // normal axis and the two axes of the face plane
+            int n = face < 2 ? 2 : (face < 4 ? 0 : 1);
+            int a = (n + 1) % 3;
+            int b = (n + 2) % 3;
+
+            std::vector<uint32_t> mask(dims[a] * dims[b]);
 
-                    // Add indices
-                    indices.push_back(indexOffset + 0);
-                    indices.push_back(indexOffset + 1);
-                    indices.push_back(indexOffset + 2);
-                    indices.push_back(indexOffset + 0);
-                    indices.push_back(indexOffset + 2);
-                    indices.push_back(indexOffset + 3);
-                    indexOffset += 4;
+            for (int slice = 0; slice < dims[n]; ++slice) {
+                int pos[3];
+                pos[n] = slice;
+                for (int j = 0; j < dims[b]; ++j) {
+                    for (int i = 0; i < dims[a]; ++i) {
+                        pos[a] = i;
+                        pos[b] = j;
+                        mask[j * dims[a] + i] = faceKeys[face * SECTION_VOLUME + get_index(pos[0], pos[1], pos[2])];
+                    }
+                }
+
+                for (int j = 0; j < dims[b]; ++j) {
+                    for (int i = 0; i < dims[a]; ) {
+                        uint32_t key = mask[j * dims[a] + i];
+                        if (!key) {
+                            ++i;
+                            continue;
+                        }
+
+                        // only faces with the same AO on all four corners keep
+                        // the exact same shading when stretched
+                        uint32_t ao = key >> 8;
+                        bool mergeable = greedy && (ao == 0x00 || ao == 0x55 || ao == 0xAA || ao == 0xFF);
+
+                        int w = 1;
+                        int h = 1;
+                        if (mergeable) {
+                            while (i + w < dims[a] && mask[j * dims[a] + i + w] == key) ++w;
+
+                            while (j + h < dims[b]) {
+                                bool rowMatches = true;
+                                for (int k = 0; k < w; ++k) {
+                                    if (mask[(j + h) * dims[a] + i + k] != key) {
+                                        rowMatches = false;
+                                        break;
+                                    }
+                                }
+                                if (!rowMatches) break;
+                                ++h;
+                            }
+                        }
+
+                        for (int dj = 0; dj < h; ++dj)
+                            for (int di = 0; di < w; ++di)
+                                mask[(j + dj) * dims[a] + i + di] = 0;
+
+                        int start[3];
+                        int ext[3];
+                        start[n] = slice; start[a] = i; start[b] = j;
+                        ext[n] = 1;       ext[a] = w; ext[b] = h;
+                        start[1] += baseY;
+                        emit_quad(face, start, ext, key);
+
+                        i += w;
+                    }
                 }
             }
         }
     }
 
-    vao.bind();
-    if (vbo) {
-        vbo->free();
-        delete vbo;
-    }
-    if (ebo) {
-        ebo->free();
-        delete ebo;
-    }
+    return mesh;
+}
+
+void Chunk::upload_mesh(const ChunkMeshData& mesh, QuadIndexBuffer& quadIndices, MeshArena& arena) {
+    // writes the built mesh to the chunk's range of the arena, in place when it fits (main thread only)
+    quadIndices.reserve(mesh.quad_count());
+
+    meshArena = &arena;
+    arena.upload(meshRange, mesh.vertices.data(), (uint32_t)mesh.vertices.size(), chunkX * CHUNK_SIZE, chunkZ * CHUNK_SIZE);
 
-    vbo = new VBO(vertices.data(), vertices.size() * sizeof(GLfloat));
-    ebo = new EBO(indices.data(), indices.size() * sizeof(GLuint));
+    indexCount = (GLsizei)mesh.quad_count() * 6;
+    faceCount = mesh.faceCount;
+    meshMinY = mesh.minY;
+    meshMaxY = mesh.maxY;
+}
+
+void Chunk::queue_draw(MeshArena& arena) const {
+    // drawn with the other chunks of its arena page, the origin comes from the arena
+    if (indexCount == 0 || !meshRange.valid()) return;
+    arena.queue_draw(meshRange, indexCount);
+}
+
+int Chunk::get_face_count() const {
+    return faceCount;
+}
 
-    vao.link_VBO(*vbo, 0, 3, GL_FLOAT, 6 * sizeof(float), (void*)0);                   // Position
-    vao.link_VBO(*vbo, 1, 2, GL_FLOAT, 6 * sizeof(float), (void*)(3 * sizeof(float))); // TextCoords
-    vao.link_VBO(*vbo, 2, 1, GL_FLOAT, 6 * sizeof(float), (void*)(5 * sizeof(float))); // AO 
-    vao.unbind();
+int Chunk::get_quad_count() const {
+    return indexCount / 6;
 }
 
-void Chunk::draw() {
-    vao.bind();
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+void Chunk::get_mesh_bounds(glm::vec3& min, glm::vec3& max) const {
+    // world coords, vertices sit half a block below their block corners (see defaultShader.vert)
+    min = glm::vec3(chunkX * CHUNK_SIZE, meshMinY, chunkZ * CHUNK_SIZE) - glm::vec3(0.5f);
+    max = glm::vec3((chunkX + 1) * CHUNK_SIZE, meshMaxY, (chunkZ + 1) * CHUNK_SIZE) - glm::vec3(0.5f);
 }
@@ -0,0 +1,41 @@
+#include "chunkSection.hpp"
+
+ChunkSection::ChunkSection(int volume) : volume(volume) {}
+
+void ChunkSection::set(int index, BlockID id) {
+    if (!storage) {
+        if (id == uniform) return;
+
+        // first different block, the section needs its own storage now
+        storage = std::make_unique<BlockStorage>(volume);
+        if (uniform != BLOCK_AIR) {
+            std::vector<BlockID> ids(volume, uniform);
+            storage->assign(ids.data());
+        }
+    }
+    storage->set(index, id);
+}
+
+void ChunkSection::assign(const BlockID* ids) {
+    bool same = true;
+    for (int i = 1; i < volume && same; ++i)
+        same = ids[i] == ids[0];
+
+    if (same) {
+        uniform = ids[0];
+        storage.reset();
+        return;
+    }
+
+    if (!storage) storage = std::make_unique<BlockStorage>(volume);
+    storage->assign(ids);
+}
+
+ChunkSection::Kind ChunkSection::kind() const {
+    if (storage) return MIXED;
+    return uniform == BLOCK_AIR ? EMPTY : UNIFORM;
+}
+
+size_t ChunkSection::memory_bytes() const {
+    return storage ? storage->memory_bytes() : 0;
+}
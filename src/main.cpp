@@ -1,5 +1,4 @@
 #include <iostream>
-#include <ctime>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -8,6 +7,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "shaderClass.hpp"
+#include "cameraBuffer.hpp"
 #include "textureClass.hpp"
 #include "windowClass.hpp"
 #include "cameraClass.hpp"
@@ -15,16 +15,24 @@
 #include "wireBox.hpp"
 #include "selectedBlock.hpp"
 #include "sea.hpp"
+#include "benchmark.hpp"
 
 World world;
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+        return run_benchmarks();
+    // scripted low flight over the terrain, prints culling stats at the end
+    bool flythrough = argc > 1 && std::string(argv[1]) == "--flythrough";
+    const float flythroughSeconds = 30.0f;
+
     GLFWwindow* window = Window::window_init();
     
     Shader defaultShader("shaders/defaultShader.vert", "shaders/defaultShader.frag");
     Shader wireShader("shaders/wireShader.vert", "shaders/wireShader.frag");
     Shader seaShader("shaders/seaShader.vert", "shaders/seaShader.frag");
     Shader selectedBlockShader("shaders/selectedBlockShader.vert", "shaders/selectedBlockShader.frag");
+    Shader occlusionShader("shaders/occlusionShader.vert", "shaders/occlusionShader.frag");
 
     Camera cam(Window::SCREEN_WIDTH, Window::SCREEN_HEIGHT);
     glfwSetWindowUserPointer(window, &cam);
@@ -35,30 +43,35 @@ int main() {
     float fpsTimer = 0.0f;
     int frameCount = 0;
 
-    srand(time(nullptr) + rand());
-
     std::string dir = "textures/atlas.png";
     Texture atlasTex(dir.c_str(), GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
     atlasTex.bind();
 
     glm::mat4 defaultProjMatrix = cam.get_projection_matrix(Window::SCREEN_WIDTH / Window::SCREEN_HEIGHT);
 
+    // view, projection and fog of every program, uploaded once per frame
+    CameraBuffer cameraBuffer;
+    CameraData cameraData;
+    cameraData.projection = defaultProjMatrix;
+    cameraBuffer.attach(defaultShader);
+    cameraBuffer.attach(selectedBlockShader);
+    cameraBuffer.attach(seaShader);
+    cameraBuffer.attach(wireShader);
+    cameraBuffer.attach(occlusionShader);
+
     defaultShader.activate();
-    defaultShader.set_mat4("projection", defaultProjMatrix);
     defaultShader.set_mat4("model", glm::mat4(1.0f));
+    defaultShader.set_int("rangeOrigins", MeshArena::ORIGIN_TEXTURE_UNIT);
 
     SelectedBlock currBlock(BLOCK_AIR);
-    selectedBlockShader.activate();
-    selectedBlockShader.set_mat4("projection", defaultProjMatrix);
-
     Sea sea;
     const float seaHeight = 8.4f;
-    seaShader.activate();
-    seaShader.set_mat4("projection", defaultProjMatrix);
-
     wireBox wBox;
-    wireShader.activate();
-    wireShader.set_mat4("projection", defaultProjMatrix);
+
+    // flythrough totals, from the first full view on
+    long flyFrames = 0, flyChunks = 0, flyOccludedChunks = 0;
+    long long flyQuads = 0, flyOccludedQuads = 0;
+    float flySeconds = 0.0f;
 
     // main loop
     while(!glfwWindowShouldClose(window)) {
@@ -69,40 +82,91 @@ int main() {
         frameCount++;
         fpsTimer += deltaTime;
 
+        // wireframe leaves only lines in the depth buffer and draws the query
+        // boxes as lines too, so the queries would say hidden chunks are visible
+        bool occlusionCulling = cam.occlusionCulling && !cam.wireframe;
+
         if (fpsTimer >= 0.2f) {
             int fps = frameCount / fpsTimer;
-            std::string title = "Minecraft Clone - FPS: " + std::to_string(fps);
+            MeshStats stats = world.get_mesh_stats();
+            RemeshStats remesh = world.get_remesh_stats();
+            LoadStats load = world.get_load_stats();
+            UploadStats upload = world.get_upload_stats();
+            MeshArenaStats arena = world.get_arena_stats();
+            int saved = stats.faces > 0 ? int(100 * (stats.faces - stats.quads) / stats.faces) : 0;
+            long frustumQuads = stats.quads + stats.occludedQuads;
+            int occludedQuads = frustumQuads > 0 ? int(100 * stats.occludedQuads / frustumQuads) : 0;
+            std::string title = "Minecraft Clone - FPS: " + std::to_string(fps) +
+                                " - Triangles: " + std::to_string(stats.quads * 2) +
+                                (cam.greedyMeshing ? " (greedy -" + std::to_string(saved) + "%)" : "") +
+                                (occlusionCulling ? " (occluded " + std::to_string(stats.occludedChunks) + " chunks -" +
+                                                        std::to_string(occludedQuads) + "%)" : "") +
+                                " - Draws: " + std::to_string(stats.drawCalls) + (cam.batchedDrawing ? " batched" : "") +
+                                " (" + std::to_string(int(stats.submitUs)) + " us)" +
+                                " - Remeshes: " + std::to_string(remesh.built) + "/" + std::to_string(remesh.requested) +
+                                (load.missingChunks > 0 ? " - Loading: " + std::to_string(load.missingChunks)
+                                                        : " - Full view: " + std::to_string(int(load.lastFullViewMs)) + " ms") +
+                                " - Upload p50/p99: " + std::to_string(int(upload.p50Us)) + "/" + std::to_string(int(upload.p99Us)) + " us" +
+                                " - Meshes: " + std::to_string(arena.totalBytes >> 20) + " MB (" +
+                                std::to_string(int(arena.fragmentation * 100)) + "% fragmented)";
             glfwSetWindowTitle(window, title.c_str());
             frameCount = 0;
             fpsTimer = 0.0f;
         }
 
-        world.update(cam.position);
+        world.set_greedy_meshing(cam.greedyMeshing);
+        world.set_batched_drawing(cam.batchedDrawing);
+        world.set_occlusion_culling(occlusionCulling);
+        if (flythrough) {
+            // weaving along +x low enough for hills to hide what is behind them, looking around
+            cam.set_view(glm::vec3(8.0f * currentFrame, 18.0f, 24.0f * std::sin(currentFrame * 0.2f)),
+                         40.0f * std::sin(currentFrame * 0.3f), -5.0f);
+        }
+        world.update(cam.position, cam.front);
         
         cam.process_keyboard(window, deltaTime);
 
         glClearColor(0.6, 0.8, 1.0, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        defaultShader.activate();
         glm::mat4 camMatrix = cam.get_view_matrix();
-        defaultShader.set_mat4("view", camMatrix);
-        if(cam.position.y <= seaHeight && cam.position.y >= -0.5)
-            defaultShader.set_bool("underWater", true);
-        else defaultShader.set_bool("underWater", false);
-        world.render(camMatrix, defaultProjMatrix);
+        cameraData.view = camMatrix;
+        cameraData.position = glm::vec4(cam.position, 1.0f);
+        // fog covers the edge of the loaded world
+        cameraData.fogEnd = float(world.get_render_distance() * CHUNK_SIZE);
+        cameraData.underWater = cam.position.y <= seaHeight && cam.position.y >= -0.5;
+        cameraBuffer.update(cameraData);
+
+        defaultShader.activate();
+        world.render(occlusionShader, camMatrix, defaultProjMatrix);
+
+        if (flythrough && world.get_load_stats().firstFullViewMs > 0) {
+            MeshStats stats = world.get_mesh_stats();
+            flyFrames++;
+            flySeconds += deltaTime;
+            flyChunks += stats.drawnChunks + stats.occludedChunks;
+            flyOccludedChunks += stats.occludedChunks;
+            flyQuads += stats.quads + stats.occludedQuads;
+            flyOccludedQuads += stats.occludedQuads;
+        }
+        if (flythrough && currentFrame >= flythroughSeconds) {
+            std::cout << "Flythrough: " << flyFrames << " frames, " << (flySeconds > 0 ? flyFrames / flySeconds : 0) << " fps\n"
+                      << "  chunks in frustum per frame " << (flyFrames > 0 ? flyChunks / flyFrames : 0)
+                      << ", occluded " << (flyChunks > 0 ? 100.0 * flyOccludedChunks / flyChunks : 0) << "%\n"
+                      << "  triangles in frustum per frame " << (flyFrames > 0 ? 2 * flyQuads / flyFrames : 0)
+                      << ", saved " << (flyQuads > 0 ? 100.0 * flyOccludedQuads / flyQuads : 0) << "%\n";
+            glfwSetWindowShouldClose(window, true);
+        }
 
         glm::vec3 seaPos = {cam.position.x, seaHeight, cam.position.z};
         glm::mat4 seaModel = sea.calc_pos(seaPos, 150);
         seaShader.activate();
         seaShader.set_mat4("model", seaModel);
-        seaShader.set_mat4("view", camMatrix);
         sea.render();
         
         glm::mat4 selectedBlockModel = currBlock.calc_pos(cam.position, cam.front, cam.up);
         selectedBlockShader.activate();
         selectedBlockShader.set_mat4("model", selectedBlockModel);
-        selectedBlockShader.set_mat4("view", camMatrix);
         currBlock.update(cam.currBlock);
         currBlock.render();
 
@@ -113,7 +177,6 @@ int main() {
 
             wireShader.activate();
             wireShader.set_mat4("model", wire_model);
-            wireShader.set_mat4("view", camMatrix);
             wBox.render(cam.wireframe);
         }
 
@@ -122,11 +185,13 @@ int main() {
     }
     // free memory
     world.free();
+    cameraBuffer.free();
     atlasTex.free();
     defaultShader.free();
     wireShader.free();
     seaShader.free();
     selectedBlockShader.free();
+    occlusionShader.free();
 
     while(!world.freed) {
         // wait for the world to free every saved chunk
@@ -0,0 +1,330 @@
+#include "meshArena.hpp"
+
+#include <algorithm>
+
+// ranges are reserved in granules of 16 quads, so a mesh that grows a little
+// after an edit still fits where it is
+static uint32_t round_up(uint32_t vertices) {
+    return (vertices + MeshArena::GRANULE - 1) & ~(MeshArena::GRANULE - 1);
+}
+
+MeshArena::MeshArena(QuadIndexBuffer& quadIndices, uint32_t pageVertices)
+    : quadIndices(quadIndices), pageVertices(pageVertices) {
+    // GL buffers are created on the first upload, once there is a context
+}
+
+void MeshArena::upload(MeshRange& range, const uint32_t* vertices, uint32_t count, int originX, int originZ) {
+    if (count == 0) {
+        release(range);
+        return;
+    }
+
+    uint32_t size = round_up(count);
+    if (range.valid() && size <= range.capacity) {
+        // fits where the previous mesh was, a tail left over by a shrunk mesh goes back
+        Page& page = pages[range.page];
+        if (size < range.capacity / 2) {
+            add_free(page, range.offset + size, range.capacity - size);
+            range.capacity = size;
+        }
+        counters.inPlaceUploads++;
+    } else {
+        if (range.valid()) {
+            release(range);
+            counters.moves++;
+        }
+
+        bool placed = false;
+        for (int page = 0; page < (int)pages.size() && !placed; ++page)
+            placed = allocate(page, size, range);
+        if (!placed)
+            allocate(create_page(std::max(pageVertices, size)), size, range);
+    }
+
+    range.count = count;
+    range.originX = originX;
+    range.originZ = originZ;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pages[range.page].buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(range.offset) * sizeof(uint32_t),
+                    GLsizeiptr(count) * sizeof(uint32_t), vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    write_origins(pages[range.page], range);
+}
+
+void MeshArena::write_origins(Page& page, const MeshRange& range) {
+    uint32_t first = range.offset >> GRANULE_LOG2;
+    uint32_t granules = range.capacity >> GRANULE_LOG2;
+    for (uint32_t i = first; i < first + granules; ++i) {
+        page.origins[i * 2] = range.originX;
+        page.origins[i * 2 + 1] = range.originZ;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, page.originBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, GLintptr(first) * 2 * sizeof(int32_t),
+                    GLsizeiptr(granules) * 2 * sizeof(int32_t), &page.origins[first * 2]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+bool MeshArena::allocate(int pageIndex, uint32_t size, MeshRange& range) {
+    // first free block large enough, the rest of it stays free
+    Page& page = pages[pageIndex];
+    for (size_t i = 0; i < page.freeBlocks.size(); ++i) {
+        FreeBlock& block = page.freeBlocks[i];
+        if (block.size < size) continue;
+
+        range.page = pageIndex;
+        range.offset = block.offset;
+        range.capacity = size;
+        page.ranges.push_back(&range);
+
+        block.offset += size;
+        block.size -= size;
+        if (block.size == 0)
+            page.freeBlocks.erase(page.freeBlocks.begin() + i);
+        return true;
+    }
+    return false;
+}
+
+void MeshArena::release(MeshRange& range) {
+    if (!range.valid()) return;
+
+    Page& page = pages[range.page];
+    add_free(page, range.offset, range.capacity);
+    auto it = std::find(page.ranges.begin(), page.ranges.end(), &range);
+    if (it != page.ranges.end()) {
+        *it = page.ranges.back();
+        page.ranges.pop_back();
+    }
+    range = MeshRange();
+}
+
+void MeshArena::add_free(Page& page, uint32_t offset, uint32_t size) {
+    // keeps the list sorted and merges the block with the free ones around it
+    auto next = std::lower_bound(page.freeBlocks.begin(), page.freeBlocks.end(), offset,
+                                 [](const FreeBlock& block, uint32_t value) { return block.offset < value; });
+    next = page.freeBlocks.insert(next, { offset, size });
+
+    auto following = next + 1;
+    if (following != page.freeBlocks.end() && next->offset + next->size == following->offset) {
+        next->size += following->size;
+        page.freeBlocks.erase(following);
+    }
+    if (next != page.freeBlocks.begin()) {
+        auto previous = next - 1;
+        if (previous->offset + previous->size == next->offset) {
+            previous->size += next->size;
+            page.freeBlocks.erase(next);
+        }
+    }
+}
+
+int MeshArena::create_page(uint32_t capacity) {
+    // reuses the slot of a released page, so the page numbers of live ranges stay valid
+    int index = -1;
+    for (int i = 0; i < (int)pages.size(); ++i)
+        if (pages[i].capacity == 0) index = i;
+    if (index == -1) {
+        index = (int)pages.size();
+        pages.emplace_back();
+    }
+
+    Page& page = pages[index];
+    page.capacity = capacity;
+    page.freeBlocks = { { 0, capacity } };
+    page.ranges.clear();
+
+    glGenBuffers(1, &page.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(capacity) * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glGenVertexArrays(1, &page.vao);
+    link_vao(page);
+
+    page.origins.assign((capacity >> GRANULE_LOG2) * 2, 0);
+    glGenBuffers(1, &page.originBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, page.originBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(page.origins.size()) * sizeof(int32_t), page.origins.data(), GL_DYNAMIC_DRAW);
+    glGenTextures(1, &page.originTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, page.originTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, page.originBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return index;
+}
+
+void MeshArena::free_page(Page& page) {
+    glDeleteBuffers(1, &page.buffer);
+    glDeleteVertexArrays(1, &page.vao);
+    glDeleteTextures(1, &page.originTexture);
+    glDeleteBuffers(1, &page.originBuffer);
+    page = Page();
+}
+
+void MeshArena::link_vao(Page& page) {
+    // packed vertex attribute of the page buffer and the shared quad indices,
+    // chunks pick their range with the base vertex of the draw call
+    glBindVertexArray(page.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, page.buffer);
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+    glEnableVertexAttribArray(0);
+    quadIndices.bind();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+float MeshArena::fragmentation(const Page& page, uint32_t& freeSize, uint32_t& largest) {
+    freeSize = 0;
+    largest = 0;
+    for (const FreeBlock& block : page.freeBlocks) {
+        freeSize += block.size;
+        largest = std::max(largest, block.size);
+    }
+    return freeSize > 0 ? 1.0f - float(largest) / float(freeSize) : 0.0f;
+}
+
+void MeshArena::maintain() {
+    int worst = -1;
+    float worstFragmentation = 0.5f; // below that, the free space is still mostly usable
+
+    for (int i = 0; i < (int)pages.size(); ++i) {
+        Page& page = pages[i];
+        if (page.capacity == 0) continue;
+
+        // empty pages past the first give their storage back
+        if (page.ranges.empty() && i > 0) {
+            free_page(page);
+            continue;
+        }
+
+        uint32_t freeSize, largest;
+        float pageFragmentation = fragmentation(page, freeSize, largest);
+        if (freeSize >= page.capacity / 4 && pageFragmentation > worstFragmentation) {
+            worst = i;
+            worstFragmentation = pageFragmentation;
+        }
+    }
+
+    if (worst != -1)
+        compact(worst);
+}
+
+void MeshArena::compact(int pageIndex) {
+    // copies the meshes one after the other into a new buffer on the GPU,
+    // trimming their ranges to what they use, the free space ends up in one block
+    Page& page = pages[pageIndex];
+    std::sort(page.ranges.begin(), page.ranges.end(),
+              [](const MeshRange* a, const MeshRange* b) { return a->offset < b->offset; });
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, page.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(page.capacity) * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+    uint32_t cursor = 0;
+    for (MeshRange* range : page.ranges) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(range->offset) * sizeof(uint32_t),
+                            GLintptr(cursor) * sizeof(uint32_t), GLsizeiptr(range->count) * sizeof(uint32_t));
+        range->offset = cursor;
+        range->capacity = round_up(range->count);
+        cursor += range->capacity;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &page.buffer);
+    page.buffer = buffer;
+    page.freeBlocks.clear();
+    if (cursor < page.capacity)
+        page.freeBlocks.push_back({ cursor, page.capacity - cursor });
+    link_vao(page);
+    for (MeshRange* range : page.ranges)
+        write_origins(page, *range);
+    counters.compactions++;
+}
+
+void MeshArena::bind_page(Page& page) {
+    glBindVertexArray(page.vao);
+    glActiveTexture(GL_TEXTURE0 + ORIGIN_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, page.originTexture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void MeshArena::queue_draw(const MeshRange& range, GLsizei indexCount) {
+    Page& page = pages[range.page];
+    page.drawCounts.push_back(indexCount);
+    page.drawBaseVertices.push_back((GLint)range.offset);
+}
+
+int MeshArena::draw_queued(GLenum indexType, bool batched) {
+    int drawCalls = 0;
+    for (Page& page : pages) {
+        size_t draws = page.drawCounts.size();
+        if (draws == 0) continue;
+        bind_page(page);
+
+        if (!batched) {
+            for (size_t i = 0; i < draws; ++i)
+                glDrawElementsBaseVertex(GL_TRIANGLES, page.drawCounts[i], indexType, 0, page.drawBaseVertices[i]);
+            drawCalls += (int)draws;
+        } else if (GLAD_GL_VERSION_4_3) {
+            // the commands go through a buffer the GPU reads, the CPU only submits one call
+            drawCommands.resize(draws);
+            for (size_t i = 0; i < draws; ++i)
+                drawCommands[i] = { (GLuint)page.drawCounts[i], 1, 0, page.drawBaseVertices[i], 0 };
+            if (!indirectBuffer) glGenBuffers(1, &indirectBuffer);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(draws * sizeof(DrawCommand)), drawCommands.data(), GL_STREAM_DRAW);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr, (GLsizei)draws, 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            drawCalls++;
+        } else {
+            drawIndices.resize(draws, nullptr);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, page.drawCounts.data(), indexType, drawIndices.data(),
+                                          (GLsizei)draws, page.drawBaseVertices.data());
+            drawCalls++;
+        }
+
+        page.drawCounts.clear();
+        page.drawBaseVertices.clear();
+    }
+    glBindVertexArray(0);
+    return drawCalls;
+}
+
+MeshArenaStats MeshArena::get_stats() const {
+    MeshArenaStats stats = counters;
+    size_t freeBytes = 0;
+
+    for (const Page& page : pages) {
+        if (page.capacity == 0) continue;
+        uint32_t freeSize, largest;
+        fragmentation(page, freeSize, largest);
+
+        stats.pages++;
+        stats.meshes += (int)page.ranges.size();
+        stats.totalBytes += size_t(page.capacity) * sizeof(uint32_t);
+        stats.usedBytes += size_t(page.capacity - freeSize) * sizeof(uint32_t);
+        stats.largestFreeBytes = std::max(stats.largestFreeBytes, size_t(largest) * sizeof(uint32_t));
+        freeBytes += size_t(freeSize) * sizeof(uint32_t);
+    }
+    stats.fragmentation = freeBytes > 0 ? 1.0f - float(stats.largestFreeBytes) / float(freeBytes) : 0.0f;
+    return stats;
+}
+
+void MeshArena::free() {
+    for (Page& page : pages) {
+        if (page.capacity == 0) continue;
+        // live ranges point to pages that don't exist anymore
+        for (MeshRange* range : page.ranges)
+            *range = MeshRange();
+        free_page(page);
+    }
+    pages.clear();
+    if (indirectBuffer) {
+        glDeleteBuffers(1, &indirectBuffer);
+        indirectBuffer = 0;
+    }
+}
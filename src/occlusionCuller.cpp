@@ -0,0 +1,119 @@
+#include "occlusionCuller.hpp"
+
+// unit cube as triangles, faces are drawn both ways round (culling is off for the boxes)
+static const GLfloat cubeVerts[] = {
+    0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 0, 0,  1, 1, 0,  0, 1, 0, // -Z
+    0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 0, 1,  1, 1, 1,  0, 1, 1, // +Z
+    0, 0, 0,  0, 1, 0,  0, 1, 1,  0, 0, 0,  0, 1, 1,  0, 0, 1, // -X
+    1, 0, 0,  1, 1, 0,  1, 1, 1,  1, 0, 0,  1, 1, 1,  1, 0, 1, // +X
+    0, 0, 0,  1, 0, 0,  1, 0, 1,  0, 0, 0,  1, 0, 1,  0, 0, 1, // -Y
+    0, 1, 0,  1, 1, 0,  1, 1, 1,  0, 1, 0,  1, 1, 1,  0, 1, 1  // +Y
+};
+
+// boxes are pushed out a little, so a chunk's own surface lying on its box
+// (top of the terrain, chunk borders) doesn't fail the depth test against itself
+static const float BOX_MARGIN = 0.1f;
+
+bool OcclusionCuller::is_visible(int chunkX, int chunkZ, const glm::vec3& boxMin, const glm::vec3& boxMax, long frame) {
+    Query* query = queries.find(chunkX, chunkZ);
+    // no query last frame: the chunk just got a mesh or came back in the frustum
+    if (!query || query->frame < frame - 1)
+        return true;
+
+    if (query->pending) {
+        GLuint available = 0;
+        glGetQueryObjectuiv(query->ID, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return true;
+
+        GLuint anySamples = 0;
+        glGetQueryObjectuiv(query->ID, GL_QUERY_RESULT, &anySamples);
+        query->visible = anySamples != 0;
+        query->pending = false;
+    }
+
+    return query->visible || contains_camera(boxMin, boxMax);
+}
+
+void OcclusionCuller::begin_queries(Shader& shader) {
+    if (!vao) {
+        vao = new VAO();
+        vbo = new VBO(cubeVerts, sizeof(cubeVerts));
+        vao->bind();
+        vao->link_VBO(*vbo, 0, 3, GL_FLOAT, 3 * sizeof(float), (void*)0);
+        vao->unbind();
+    }
+
+    // only the depth test matters, the boxes leave no trace in the frame
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+
+    boxShader = &shader;
+    boxShader->activate();
+    vao->bind();
+}
+
+void OcclusionCuller::query(int chunkX, int chunkZ, const glm::vec3& boxMin, const glm::vec3& boxMax, long frame) {
+    Query& query = queries[{ chunkX, chunkZ }];
+    if (query.ID == 0)
+        glGenQueries(1, &query.ID);
+    query.frame = frame;
+
+    // the near plane would clip a box around the camera, it's visible anyway
+    if (contains_camera(boxMin, boxMax)) {
+        query.visible = true;
+        query.pending = false;
+        return;
+    }
+
+    boxShader->set_vec3("boxMin", boxMin - glm::vec3(BOX_MARGIN));
+    boxShader->set_vec3("boxSize", boxMax - boxMin + glm::vec3(2.0f * BOX_MARGIN));
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, query.ID);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    query.pending = true;
+}
+
+void OcclusionCuller::end_queries() {
+    vao->unbind();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+    boxShader = nullptr;
+}
+
+bool OcclusionCuller::contains_camera(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    // a block of margin covers the near plane
+    const float margin = 1.0f;
+    for (int axis = 0; axis < 3; ++axis)
+        if (cameraPosition[axis] < boxMin[axis] - margin || cameraPosition[axis] > boxMax[axis] + margin)
+            return false;
+    return true;
+}
+
+void OcclusionCuller::forget(int chunkX, int chunkZ) {
+    Query* query = queries.find(chunkX, chunkZ);
+    if (!query) return;
+    if (query->ID != 0)
+        glDeleteQueries(1, &query->ID);
+    queries.erase({ chunkX, chunkZ });
+}
+
+void OcclusionCuller::free() {
+    for (auto& entry : queries)
+        if (entry.second.ID != 0)
+            glDeleteQueries(1, &entry.second.ID);
+    queries.clear();
+
+    if (vao) {
+        vao->free();
+        delete vao;
+        vao = nullptr;
+    }
+    if (vbo) {
+        vbo->free();
+        delete vbo;
+        vbo = nullptr;
+    }
+}
@@ -0,0 +1,64 @@
+#include "quadIndexBuffer.hpp"
+
+QuadIndexBuffer::QuadIndexBuffer(int initialQuads) : initialQuads(initialQuads) {
+    // GL buffer is created on first reserve, once there is a context
+}
+
+template <typename T>
+void QuadIndexBuffer::fill(std::vector<T>& indices, int quads) {
+    indices.resize(quads * 6);
+    for (int i = 0; i < quads; ++i) {
+        T offset = T(i * 4);
+        indices[i * 6 + 0] = offset + 0;
+        indices[i * 6 + 1] = offset + 1;
+        indices[i * 6 + 2] = offset + 2;
+        indices[i * 6 + 3] = offset + 0;
+        indices[i * 6 + 4] = offset + 2;
+        indices[i * 6 + 5] = offset + 3;
+    }
+}
+
+void QuadIndexBuffer::reserve(int quads) {
+    // grows the buffer in place, VAOs keep pointing to the same buffer ID
+    if (ID != 0 && quads <= capacity) return;
+
+    int newCapacity = capacity > 0 ? capacity : initialQuads;
+    while (newCapacity < quads)
+        newCapacity *= 2;
+
+    if (ID == 0)
+        glGenBuffers(1, &ID);
+
+    // copy write target, so the bound VAO's element buffer isn't touched
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+    if (newCapacity * 4 <= 65536) {
+        std::vector<GLushort> indices;
+        fill(indices, newCapacity);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_SHORT;
+    } else {
+        std::vector<GLuint> indices;
+        fill(indices, newCapacity);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        indexType = GL_UNSIGNED_INT;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    capacity = newCapacity;
+}
+
+void QuadIndexBuffer::bind() {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+}
+
+void QuadIndexBuffer::free() {
+    if (glIsBuffer(ID)) {
+        glDeleteBuffers(1, &ID);
+        ID = 0;
+    }
+    capacity = 0;
+}
+
+GLenum QuadIndexBuffer::index_type() const {
+    return indexType;
+}
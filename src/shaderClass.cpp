@@ -1,5 +1,7 @@
 #include "shaderClass.hpp"
 
+#include <cstring>
+
 // Read text file --> outputs string
 std::string file_to_string(const char* filename) {
     std::ifstream in(filename, std::ios::binary);
@@ -16,10 +18,21 @@ std::string file_to_string(const char* filename) {
     throw std::runtime_error("Couldn't open the file " + std::string(filename));
 }
 
+// declarations shared by every program (the Camera uniform block)
+static const char* SHARED_SOURCE_FILE = "shaders/camera.glsl";
+
+static std::string insert_shared_source(const std::string& code, const std::string& shared) {
+    // #version has to stay the first line, #line keeps error line numbers matching the file
+    size_t versionEnd = code.find('\n');
+    if (versionEnd == std::string::npos) return code;
+    return code.substr(0, versionEnd + 1) + shared + "\n#line 2\n" + code.substr(versionEnd + 1);
+}
+
 Shader::Shader(const char* vertexFile, const char* fragmentFile) {
     // Get file source code
-    std::string vertexCode = file_to_string(vertexFile);
-    std::string fragmentCode = file_to_string(fragmentFile);
+    std::string shared = file_to_string(SHARED_SOURCE_FILE);
+    std::string vertexCode = insert_shared_source(file_to_string(vertexFile), shared);
+    std::string fragmentCode = insert_shared_source(file_to_string(fragmentFile), shared);
     const char* vertexSource = vertexCode.c_str();
     const char* fragmentSource = fragmentCode.c_str();
 
@@ -45,6 +58,49 @@ Shader::Shader(const char* vertexFile, const char* fragmentFile) {
     // Free useless obj
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    resolve_uniforms();
+}
+
+void Shader::resolve_uniforms() {
+    // locations are queried once here instead of at every set_*
+    GLint count = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+
+    char name[256];
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(ID, GLuint(i), sizeof(name), &length, &size, &type, name);
+
+        // arrays are reported as name[0], members of uniform blocks have no location
+        std::string uniformName(name, length);
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            uniformName.resize(uniformName.size() - 3);
+        GLint location = glGetUniformLocation(ID, name);
+        if (location == -1) continue;
+
+        Uniform uniform;
+        uniform.name = uniformName;
+        uniform.location = location;
+        uniforms.push_back(uniform);
+    }
+}
+
+Shader::Uniform* Shader::find_uniform(const char* name) {
+    for (Uniform& uniform : uniforms)
+        if (uniform.name == name) return &uniform;
+    return nullptr;
+}
+
+bool Shader::changed(Uniform& uniform, const void* value, size_t bytes) {
+    // keeps the value, so setting it again is a memcmp and no GL call
+    if (uniform.hasValue && std::memcmp(uniform.value, value, bytes) == 0)
+        return false;
+    std::memcpy(uniform.value, value, bytes);
+    uniform.hasValue = true;
+    return true;
 }
 
 void Shader::activate() {
@@ -56,13 +112,35 @@ void Shader::free() {
 }
 
 // Send mat4 --> shader
-void Shader::set_mat4(const std::string &name, const glm::mat4 &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+void Shader::set_mat4(const char* name, const glm::mat4 &mat) {
+    Uniform* uniform = find_uniform(name);
+    if (uniform && changed(*uniform, glm::value_ptr(mat), sizeof(glm::mat4)))
+        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(mat));
 }
 
 // Send bool --> shader
-void Shader::set_bool(const std::string &name, const bool b) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), int(b));
+void Shader::set_bool(const char* name, const bool b) {
+    set_int(name, int(b));
+}
+
+// Send int --> shader
+void Shader::set_int(const char* name, const int i) {
+    Uniform* uniform = find_uniform(name);
+    if (uniform && changed(*uniform, &i, sizeof(int)))
+        glUniform1i(uniform->location, i);
+}
+
+// Send vec3 --> shader
+void Shader::set_vec3(const char* name, const glm::vec3 &vec) {
+    Uniform* uniform = find_uniform(name);
+    if (uniform && changed(*uniform, glm::value_ptr(vec), sizeof(glm::vec3)))
+        glUniform3fv(uniform->location, 1, glm::value_ptr(vec));
+}
+
+void Shader::set_block_binding(const char* name, GLuint binding) {
+    GLuint index = glGetUniformBlockIndex(ID, name);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
 }
 
 // Shader error checker
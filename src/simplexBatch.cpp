@@ -0,0 +1,342 @@
+#include "simplexBatch.hpp"
+
+#include <cstdint>
+
+// SSE4.1 and AVX2 are checked at runtime, without them the scalar path is used
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMPLEX_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+// constants written the same way as in FastNoiseLite so they round the same
+static const int PRIME_X = 501125321;
+static const int PRIME_Y = 1136930381;
+static const float F2 = 0.5f * ((float)1.7320508075688772935274463415059 - 1);
+static const float SQRT3 = 1.7320508075688772935274463415059f;
+static const float G2 = (3 - SQRT3) / 6;
+static const float C_T = (float)(2 * (1 - 2 * G2) * (1 / G2 - 2));
+static const float C_A = (float)(-2 * (1 - 2 * G2) * (1 - 2 * G2));
+static const float G2_M1 = (float)G2 - 1;
+static const float X2_OFFSET = 2 * (float)G2 - 1;
+static const float SCALE = 99.83685446303647f;
+
+// FastNoiseLite::Lookup<float>::Gradients2D
+alignas(32) static const float GRADIENTS_2D[256] = {
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+    0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+    0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+    -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+    -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+    -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+    0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+    -0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f,
+};
+
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2 };
+
+static SimdLevel detect_simd() {
+#if defined(SIMPLEX_X86) && (defined(__GNUC__) || defined(__clang__))
+    // runs from a static initializer, before the cpu info is set up otherwise
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SIMD_SSE41;
+    return SIMD_SCALAR;
+#elif defined(SIMPLEX_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    SimdLevel level = (info[2] & (1 << 19)) ? SIMD_SSE41 : SIMD_SCALAR;
+    // the OS has to save the ymm registers too
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf < 7 || !osxsave || (_xgetbv(0) & 6) != 6) return level;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) ? SIMD_AVX2 : level;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+static const SimdLevel simdLevel = detect_simd();
+
+static inline int fast_floor(float f) {
+    // FastNoiseLite's floor, whole negative values go one lower too
+    return f >= 0 ? (int)f : (int)f - 1;
+}
+
+static inline int wrap_mul(int a, int b) {
+    return (int)(uint32_t(a) * uint32_t(b));
+}
+
+static inline int wrap_add(int a, int b) {
+    return (int)(uint32_t(a) + uint32_t(b));
+}
+
+static inline float grad_coord(int seed, int xPrimed, int yPrimed, float xd, float yd) {
+    uint32_t hash = (uint32_t(seed) ^ uint32_t(xPrimed) ^ uint32_t(yPrimed)) * 0x27d4eb2du;
+    hash ^= hash >> 15;
+    hash &= 127 << 1;
+    return xd * GRADIENTS_2D[hash] + yd * GRADIENTS_2D[hash | 1];
+}
+
+static float simplex_scalar(int seed, float frequency, float x, float y) {
+    // TransformNoiseCoordinate
+    x *= frequency;
+    y *= frequency;
+    float s = (x + y) * F2;
+    x += s;
+    y += s;
+
+    // SingleSimplex
+    int i = fast_floor(x);
+    int j = fast_floor(y);
+    float xi = (float)(x - i);
+    float yi = (float)(y - j);
+
+    float t = (xi + yi) * G2;
+    float x0 = (float)(xi - t);
+    float y0 = (float)(yi - t);
+
+    i = wrap_mul(i, PRIME_X);
+    j = wrap_mul(j, PRIME_Y);
+
+    float n0, n1, n2;
+
+    float a = 0.5f - x0 * x0 - y0 * y0;
+    if (a <= 0) n0 = 0;
+    else n0 = (a * a) * (a * a) * grad_coord(seed, i, j, x0, y0);
+
+    float c = C_T * t + (C_A + a);
+    if (c <= 0) n2 = 0;
+    else {
+        float x2 = x0 + X2_OFFSET;
+        float y2 = y0 + X2_OFFSET;
+        n2 = (c * c) * (c * c) * grad_coord(seed, wrap_add(i, PRIME_X), wrap_add(j, PRIME_Y), x2, y2);
+    }
+
+    if (y0 > x0) {
+        float x1 = x0 + G2;
+        float y1 = y0 + G2_M1;
+        float b = 0.5f - x1 * x1 - y1 * y1;
+        if (b <= 0) n1 = 0;
+        else n1 = (b * b) * (b * b) * grad_coord(seed, i, wrap_add(j, PRIME_Y), x1, y1);
+    } else {
+        float x1 = x0 + G2_M1;
+        float y1 = y0 + G2;
+        float b = 0.5f - x1 * x1 - y1 * y1;
+        if (b <= 0) n1 = 0;
+        else n1 = (b * b) * (b * b) * grad_coord(seed, wrap_add(i, PRIME_X), j, x1, y1);
+    }
+
+    return (n0 + n1 + n2) * SCALE;
+}
+
+#ifdef SIMPLEX_X86
+
+// the SIMD paths compute every corner in all lanes and zero the ones the
+// scalar path skips, the kept lanes go through the same operations
+
+TARGET_SSE41 static inline __m128 grad_sse41(__m128i seed, __m128i xPrimed, __m128i yPrimed, __m128 xd, __m128 yd) {
+    __m128i hash = _mm_mullo_epi32(_mm_xor_si128(_mm_xor_si128(seed, xPrimed), yPrimed), _mm_set1_epi32(0x27d4eb2d));
+    hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+    hash = _mm_and_si128(hash, _mm_set1_epi32(127 << 1));
+
+    // no gather before AVX2
+    alignas(16) int index[4];
+    _mm_store_si128((__m128i*)index, hash);
+    __m128 xg = _mm_setr_ps(GRADIENTS_2D[index[0]], GRADIENTS_2D[index[1]], GRADIENTS_2D[index[2]], GRADIENTS_2D[index[3]]);
+    __m128 yg = _mm_setr_ps(GRADIENTS_2D[index[0] | 1], GRADIENTS_2D[index[1] | 1], GRADIENTS_2D[index[2] | 1], GRADIENTS_2D[index[3] | 1]);
+    return _mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(yd, yg));
+}
+
+TARGET_SSE41 static inline __m128 pow4_sse41(__m128 v) {
+    __m128 square = _mm_mul_ps(v, v);
+    return _mm_mul_ps(square, square);
+}
+
+TARGET_SSE41 static int simplex_sse41(int seedValue, float frequencyValue, const float* xs, const float* ys, float* out, int count) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 frequency = _mm_set1_ps(frequencyValue);
+    const __m128i seed = _mm_set1_epi32(seedValue);
+    const __m128i primeX = _mm_set1_epi32(PRIME_X);
+    const __m128i primeY = _mm_set1_epi32(PRIME_Y);
+
+    int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(xs + n), frequency);
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(ys + n), frequency);
+        __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(F2));
+        x = _mm_add_ps(x, s);
+        y = _mm_add_ps(y, s);
+
+        // truncate, then -1 (all bits set) where negative
+        __m128i i = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmplt_ps(x, zero)));
+        __m128i j = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmplt_ps(y, zero)));
+        __m128 xi = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+        __m128 yi = _mm_sub_ps(y, _mm_cvtepi32_ps(j));
+
+        __m128 t = _mm_mul_ps(_mm_add_ps(xi, yi), _mm_set1_ps(G2));
+        __m128 x0 = _mm_sub_ps(xi, t);
+        __m128 y0 = _mm_sub_ps(yi, t);
+
+        i = _mm_mullo_epi32(i, primeX);
+        j = _mm_mullo_epi32(j, primeY);
+
+        __m128 a = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x0, x0)), _mm_mul_ps(y0, y0));
+        __m128 n0 = _mm_mul_ps(pow4_sse41(a), grad_sse41(seed, i, j, x0, y0));
+        n0 = _mm_and_ps(n0, _mm_cmpgt_ps(a, zero));
+
+        __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(C_T), t), _mm_add_ps(_mm_set1_ps(C_A), a));
+        __m128 x2 = _mm_add_ps(x0, _mm_set1_ps(X2_OFFSET));
+        __m128 y2 = _mm_add_ps(y0, _mm_set1_ps(X2_OFFSET));
+        __m128 n2 = _mm_mul_ps(pow4_sse41(c), grad_sse41(seed, _mm_add_epi32(i, primeX), _mm_add_epi32(j, primeY), x2, y2));
+        n2 = _mm_and_ps(n2, _mm_cmpgt_ps(c, zero));
+
+        // middle corner, (0, 1) above the diagonal, (1, 0) below
+        __m128 upper = _mm_cmpgt_ps(y0, x0);
+        __m128 x1 = _mm_blendv_ps(_mm_add_ps(x0, _mm_set1_ps(G2_M1)), _mm_add_ps(x0, _mm_set1_ps(G2)), upper);
+        __m128 y1 = _mm_blendv_ps(_mm_add_ps(y0, _mm_set1_ps(G2)), _mm_add_ps(y0, _mm_set1_ps(G2_M1)), upper);
+        __m128i i1 = _mm_add_epi32(i, _mm_andnot_si128(_mm_castps_si128(upper), primeX));
+        __m128i j1 = _mm_add_epi32(j, _mm_and_si128(_mm_castps_si128(upper), primeY));
+        __m128 b = _mm_sub_ps(_mm_sub_ps(half, _mm_mul_ps(x1, x1)), _mm_mul_ps(y1, y1));
+        __m128 n1 = _mm_mul_ps(pow4_sse41(b), grad_sse41(seed, i1, j1, x1, y1));
+        n1 = _mm_and_ps(n1, _mm_cmpgt_ps(b, zero));
+
+        _mm_storeu_ps(out + n, _mm_mul_ps(_mm_add_ps(_mm_add_ps(n0, n1), n2), _mm_set1_ps(SCALE)));
+    }
+    return n;
+}
+
+TARGET_AVX2 static inline __m256 grad_avx2(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256 xd, __m256 yd) {
+    __m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_xor_si256(seed, xPrimed), yPrimed), _mm256_set1_epi32(0x27d4eb2d));
+    hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+    hash = _mm256_and_si256(hash, _mm256_set1_epi32(127 << 1));
+
+    __m256 xg = _mm256_i32gather_ps(GRADIENTS_2D, hash, 4);
+    __m256 yg = _mm256_i32gather_ps(GRADIENTS_2D, _mm256_or_si256(hash, _mm256_set1_epi32(1)), 4);
+    return _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg));
+}
+
+TARGET_AVX2 static inline __m256 pow4_avx2(__m256 v) {
+    __m256 square = _mm256_mul_ps(v, v);
+    return _mm256_mul_ps(square, square);
+}
+
+TARGET_AVX2 static int simplex_avx2(int seedValue, float frequencyValue, const float* xs, const float* ys, float* out, int count) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 frequency = _mm256_set1_ps(frequencyValue);
+    const __m256i seed = _mm256_set1_epi32(seedValue);
+    const __m256i primeX = _mm256_set1_epi32(PRIME_X);
+    const __m256i primeY = _mm256_set1_epi32(PRIME_Y);
+
+    int n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 x = _mm256_mul_ps(_mm256_loadu_ps(xs + n), frequency);
+        __m256 y = _mm256_mul_ps(_mm256_loadu_ps(ys + n), frequency);
+        __m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(F2));
+        x = _mm256_add_ps(x, s);
+        y = _mm256_add_ps(y, s);
+
+        // truncate, then -1 (all bits set) where negative
+        __m256i i = _mm256_add_epi32(_mm256_cvttps_epi32(x), _mm256_castps_si256(_mm256_cmp_ps(x, zero, _CMP_LT_OQ)));
+        __m256i j = _mm256_add_epi32(_mm256_cvttps_epi32(y), _mm256_castps_si256(_mm256_cmp_ps(y, zero, _CMP_LT_OQ)));
+        __m256 xi = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+        __m256 yi = _mm256_sub_ps(y, _mm256_cvtepi32_ps(j));
+
+        __m256 t = _mm256_mul_ps(_mm256_add_ps(xi, yi), _mm256_set1_ps(G2));
+        __m256 x0 = _mm256_sub_ps(xi, t);
+        __m256 y0 = _mm256_sub_ps(yi, t);
+
+        i = _mm256_mullo_epi32(i, primeX);
+        j = _mm256_mullo_epi32(j, primeY);
+
+        __m256 a = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x0, x0)), _mm256_mul_ps(y0, y0));
+        __m256 n0 = _mm256_mul_ps(pow4_avx2(a), grad_avx2(seed, i, j, x0, y0));
+        n0 = _mm256_and_ps(n0, _mm256_cmp_ps(a, zero, _CMP_GT_OQ));
+
+        __m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(C_T), t), _mm256_add_ps(_mm256_set1_ps(C_A), a));
+        __m256 x2 = _mm256_add_ps(x0, _mm256_set1_ps(X2_OFFSET));
+        __m256 y2 = _mm256_add_ps(y0, _mm256_set1_ps(X2_OFFSET));
+        __m256 n2 = _mm256_mul_ps(pow4_avx2(c), grad_avx2(seed, _mm256_add_epi32(i, primeX), _mm256_add_epi32(j, primeY), x2, y2));
+        n2 = _mm256_and_ps(n2, _mm256_cmp_ps(c, zero, _CMP_GT_OQ));
+
+        // middle corner, (0, 1) above the diagonal, (1, 0) below
+        __m256 upper = _mm256_cmp_ps(y0, x0, _CMP_GT_OQ);
+        __m256 x1 = _mm256_blendv_ps(_mm256_add_ps(x0, _mm256_set1_ps(G2_M1)), _mm256_add_ps(x0, _mm256_set1_ps(G2)), upper);
+        __m256 y1 = _mm256_blendv_ps(_mm256_add_ps(y0, _mm256_set1_ps(G2)), _mm256_add_ps(y0, _mm256_set1_ps(G2_M1)), upper);
+        __m256i i1 = _mm256_add_epi32(i, _mm256_andnot_si256(_mm256_castps_si256(upper), primeX));
+        __m256i j1 = _mm256_add_epi32(j, _mm256_and_si256(_mm256_castps_si256(upper), primeY));
+        __m256 b = _mm256_sub_ps(_mm256_sub_ps(half, _mm256_mul_ps(x1, x1)), _mm256_mul_ps(y1, y1));
+        __m256 n1 = _mm256_mul_ps(pow4_avx2(b), grad_avx2(seed, i1, j1, x1, y1));
+        n1 = _mm256_and_ps(n1, _mm256_cmp_ps(b, zero, _CMP_GT_OQ));
+
+        _mm256_storeu_ps(out + n, _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(n0, n1), n2), _mm256_set1_ps(SCALE)));
+    }
+    return n;
+}
+
+#endif
+
+SimplexBatch::SimplexBatch(int seed, float frequency) : seed(seed), frequency(frequency) {}
+
+void SimplexBatch::evaluate(const float* x, const float* y, float* out, int count) const {
+    int n = 0;
+#ifdef SIMPLEX_X86
+    if (simdLevel == SIMD_AVX2)
+        n = simplex_avx2(seed, frequency, x, y, out, count);
+    else if (simdLevel == SIMD_SSE41)
+        n = simplex_sse41(seed, frequency, x, y, out, count);
+#endif
+    // what doesn't fill a whole register
+    for (; n < count; ++n)
+        out[n] = simplex_scalar(seed, frequency, x[n], y[n]);
+}
+
+float SimplexBatch::evaluate(float x, float y) const {
+    return simplex_scalar(seed, frequency, x, y);
+}
+
+const char* SimplexBatch::simd_name() {
+    switch (simdLevel) {
+        case SIMD_AVX2: return "avx2";
+        case SIMD_SSE41: return "sse4.1";
+        default:        return "scalar";
+    }
+}
@@ -25,9 +25,8 @@ Texture::Texture(const char* image, GLenum texType, GLenum slot, GLenum format,
 }
 
 void Texture::tex_unit(Shader& shader, const char* uniform, GLuint unit) {
-    GLuint texUni = glGetUniformLocation(shader.ID, uniform);
     shader.activate();
-    glUniform1i(texUni, unit);
+    shader.set_int(uniform, unit);
 }
 
 void Texture::bind() {
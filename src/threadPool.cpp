@@ -0,0 +1,54 @@
+#include "threadPool.hpp"
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount < 1) threadCount = 1;
+    for (int i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (stopping) return;
+        jobs.push_back(std::move(job));
+    }
+    jobsCondition.notify_one();
+}
+
+void ThreadPool::stop() {
+    // drops pending jobs, waits for the running ones to finish
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if (stopping) return;
+        stopping = true;
+        jobs.clear();
+    }
+    jobsCondition.notify_all();
+
+    for (std::thread& worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+int ThreadPool::size() const {
+    return (int)workers.size();
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -71,78 +71,622 @@ RaycastHit World::raycast(const glm::vec3& origin, const glm::vec3& direction, f
 }
 
 
-World::World() {
+World::World() : World(std::random_device{}()) {}
+
+World::World(uint32_t seed) : generator(seed),
+                 // enough quads for a checkerboard chunk, every block with six faces
+                 quadIndices(CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE / 2 * 6),
+                 meshArena(quadIndices),
+                 pool((int)std::thread::hardware_concurrency() - 1) {
     freed = false;
+
+    // chunks are meshed once they are in view, and become evictable once they leave it
+    on_chunk_enter([this](int chunkX, int chunkZ, Chunk* chunk) {
+        if (chunk->state < CHUNK_MESHED)
+            meshQueue.push_back({ chunkX, chunkZ });
+        else if (chunk->meshVersion != meshVersion)
+            mark_for_remesh(chunkX, chunkZ); // meshed with settings changed while out of view
+        if (chunk->state != CHUNK_UPLOADED)
+            update_fill(1);
+    });
+    on_chunk_leave([this](int chunkX, int chunkZ, Chunk* chunk) {
+        chunk->lastUsed = frame;
+        occlusion.forget(chunkX, chunkZ);
+        if (chunk->state != CHUNK_UPLOADED)
+            update_fill(-1);
+    });
+}
+
+void World::update(const glm::vec3& playerPos, const glm::vec3& front) {
+    // pick up the work the pool finished since last frame
+    collect_finished_jobs();
+    apply_pending_edits();
+    drain_remesh_queue();
+    frame++;
+
+    playerPosition = playerPos;
+    cameraFront = front;
+
+    auto now = std::chrono::steady_clock::now();
+    if (frame > 1) {
+        std::chrono::duration<float, std::micro> elapsed = now - lastUpdate;
+        frameUs = frameUs * 0.9f + elapsed.count() * 0.1f;
+    }
+    lastUpdate = now;
+
+    int playerChunkX = ChunkDims::chunk_coord((int)std::floor(playerPos.x));
+    int playerChunkZ = ChunkDims::chunk_coord((int)std::floor(playerPos.z));
+
+    // the active set only changes when the player crosses a chunk border
+    if (!viewValid || playerChunkX != viewX || playerChunkZ != viewZ || renderDistance != viewDistance)
+        move_view(playerChunkX, playerChunkZ);
+
+    dispatch_queued();
+    upload_ready_meshes();
+
+    if (unloadPending)
+        unload_chunks(viewX, viewZ);
+    // after unloading, so the ranges of evicted chunks count as free
+    meshArena.maintain();
 }
 
-void World::update(const glm::vec3& playerPos) {
-    int playerChunkX = (int)std::floor(playerPos.x / CHUNK_SIZE);
-    int playerChunkZ = (int)std::floor(playerPos.z / CHUNK_SIZE);
+void World::move_view(int playerChunkX, int playerChunkZ) {
+    // applies the difference between the old and the new view: chunks
+    // leaving the render distance first, then loads and entering chunks.
+    // chunks one ring past the render distance are only generated,
+    // so the visible ones are meshed against their neighbors' blocks
+    int oldDistance = viewDistance;
+    int oldX = viewX, oldZ = viewZ;
+    bool hadView = viewValid;
+
+    auto inside = [](int chunkX, int chunkZ, int centerX, int centerZ, int distance) {
+        return std::abs(chunkX - centerX) <= distance && std::abs(chunkZ - centerZ) <= distance;
+    };
+
+    if (hadView) {
+        for (int chunkX = oldX - oldDistance; chunkX <= oldX + oldDistance; ++chunkX) {
+            for (int chunkZ = oldZ - oldDistance; chunkZ <= oldZ + oldDistance; ++chunkZ) {
+                if (inside(chunkX, chunkZ, playerChunkX, playerChunkZ, renderDistance)) continue;
+
+                Chunk* chunk = *activeChunks.find(chunkX, chunkZ);
+                activeChunks.erase({ chunkX, chunkZ });
+                for (const ChunkListener& listener : leaveListeners)
+                    listener(chunkX, chunkZ, chunk);
+            }
+        }
+    }
 
-    std::unordered_map<std::pair<int, int>, Chunk*, pair_hash> newActiveChunks;
-    // get chunks around player in render distance radius
-    // and store them in new unordered map
-    for (int dx = -renderDistance; dx <= renderDistance; ++dx) {
-        for (int dz = -renderDistance; dz <= renderDistance; ++dz) {
+    int loadDistance = renderDistance + 1;
+    int oldLoadDistance = oldDistance + 1;
+    for (int dx = -loadDistance; dx <= loadDistance; ++dx) {
+        for (int dz = -loadDistance; dz <= loadDistance; ++dz) {
             int chunkX = playerChunkX + dx;
             int chunkZ = playerChunkZ + dz;
+            bool active = std::abs(dx) <= renderDistance && std::abs(dz) <= renderDistance;
+            bool wasLoaded = hadView && inside(chunkX, chunkZ, oldX, oldZ, oldLoadDistance);
+            bool wasActive = hadView && inside(chunkX, chunkZ, oldX, oldZ, oldDistance);
+            // already in the old view with the same role
+            if (wasActive || (wasLoaded && !active)) continue;
+
+            Chunk* chunk = get_chunk(chunkX, chunkZ);
+            if (!chunk)
+                chunk = load_chunk(chunkX, chunkZ);
+
+            if (!active) continue;
 
-            if (!get_chunk(chunkX, chunkZ)) {
-                load_chunk(chunkX, chunkZ);
+            activeChunks[{chunkX, chunkZ}] = chunk;
+            for (const ChunkListener& listener : enterListeners)
+                listener(chunkX, chunkZ, chunk);
+        }
+    }
+
+    viewValid = true;
+    viewX = playerChunkX;
+    viewZ = playerChunkZ;
+    viewDistance = renderDistance;
+    unloadPending = true;
+}
+
+float World::chunk_priority(int chunkX, int chunkZ, const std::optional<Frustum>& frustum) const {
+    // distance in blocks from the player to the chunk center, lowest goes first.
+    // past the chunks right around the player, the ones ahead of the camera and
+    // in the frustum count as up to half as far, the ones behind up to 1.5x
+    glm::vec2 offset((chunkX + 0.5f) * CHUNK_SIZE - playerPosition.x, (chunkZ + 0.5f) * CHUNK_SIZE - playerPosition.z);
+    float distance = glm::length(offset);
+    if (distance < CHUNK_SIZE * 1.5f) return distance;
+
+    float weight = 1.0f;
+    glm::vec2 front(cameraFront.x, cameraFront.z);
+    if (glm::length(front) > 0.0f)
+        weight -= 0.25f * glm::dot(offset / distance, glm::normalize(front));
+
+    if (frustum) {
+        glm::vec3 chunkMin(chunkX * CHUNK_SIZE, 0.0f, chunkZ * CHUNK_SIZE);
+        glm::vec3 chunkMax = chunkMin + glm::vec3(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE);
+        weight += frustum->isBoxInside(chunkMin, chunkMax) ? -0.25f : 0.25f;
+    }
+    return distance * weight;
+}
+
+void World::dispatch_queued() {
+    // generation and first meshes by priority while the pool has free slots,
+    // so a burst of requests is spread over frames and what the player looks
+    // at next can still jump ahead of what was queued earlier. a slot per job
+    // the pool can get through in four frames keeps it busy between updates
+    int jobsPerWorker = std::max(16, int(4.0f * frameUs / std::max(jobUs, 1.0f)));
+    int freeSlots = pool.size() * jobsPerWorker - jobsInFlight;
+    if (freeSlots <= 0 || (loadQueue.empty() && meshQueue.empty())) return;
+
+    std::optional<Frustum> frustum;
+    if (hasViewProjection) frustum.emplace(viewProjection);
+
+    struct QueuedJob {
+        float priority;
+        bool mesh;
+        std::pair<int, int> pos;
+        bool operator<(const QueuedJob& other) const { return priority < other.priority; }
+    };
+    std::vector<QueuedJob> queued;
+
+    for (const auto& pos : loadQueue) {
+        // unloaded before its turn, or already picked from a duplicate entry
+        Chunk* chunk = get_chunk(pos.first, pos.second);
+        if (!chunk || chunk->state != CHUNK_QUEUED || chunk->inFlight) continue;
+        queued.push_back({ chunk_priority(pos.first, pos.second, frustum), false, pos });
+    }
+    for (const auto& pos : meshQueue) {
+        // left the view before being meshed, queued again if it comes back
+        Chunk* const* active = activeChunks.find(pos.first, pos.second);
+        if (!active || (*active)->state >= CHUNK_MESHED) continue;
+        queued.push_back({ chunk_priority(pos.first, pos.second, frustum), true, pos });
+    }
+    std::sort(queued.begin(), queued.end());
+
+    loadQueue.clear();
+    meshQueue.clear();
+    for (const QueuedJob& job : queued) {
+        Chunk* chunk = get_chunk(job.pos.first, job.pos.second);
+        if (!job.mesh) {
+            if (freeSlots > 0 && !chunk->inFlight) {
+                dispatch_generation(job.pos.first, job.pos.second, chunk);
+                freeSlots--;
+            } else {
+                loadQueue.push_back(job.pos);
             }
+            continue;
+        }
+
+        // meshing waits for the chunk and its neighbors to be generated
+        if (freeSlots > 0 && chunk->state == CHUNK_DECORATED && dispatch_mesh(job.pos.first, job.pos.second, chunk))
+            freeSlots--;
+        else
+            meshQueue.push_back(job.pos);
+    }
+}
 
-            newActiveChunks[{chunkX, chunkZ}] = get_chunk(chunkX, chunkZ);
+void World::upload_ready_meshes() {
+    // nearest chunks first until the frame's byte or time budget runs out,
+    // at least one mesh per frame so a big one can't hold the queue forever
+    if (readyMeshes.empty()) return;
+
+    std::optional<Frustum> frustum;
+    if (hasViewProjection) frustum.emplace(viewProjection);
+    for (ReadyMesh& ready : readyMeshes)
+        ready.priority = chunk_priority(ready.chunkX, ready.chunkZ, frustum);
+    std::sort(readyMeshes.begin(), readyMeshes.end(),
+              [](const ReadyMesh& a, const ReadyMesh& b) { return a.priority < b.priority; });
+
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    size_t count = 0;
+    for (; count < readyMeshes.size(); ++count) {
+        ReadyMesh& ready = readyMeshes[count];
+        size_t meshBytes = ready.mesh.vertices.size() * sizeof(uint32_t);
+        std::chrono::duration<float, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        bool overBytes = uploadBudgetBytes > 0 && bytes + meshBytes > uploadBudgetBytes;
+        bool overTime = uploadBudgetUs > 0.0f && elapsed.count() >= uploadBudgetUs;
+        if (count > 0 && (overBytes || overTime)) break;
+
+        bool firstMesh = ready.chunk->state == CHUNK_MESHED;
+        ready.chunk->upload_mesh(ready.mesh, quadIndices, meshArena);
+        ready.chunk->state = CHUNK_UPLOADED;
+        bytes += meshBytes;
+        uploadedMeshes++;
+
+        Chunk* const* active = activeChunks.find(ready.chunkX, ready.chunkZ);
+        if (firstMesh && active && *active == ready.chunk)
+            update_fill(-1);
+    }
+    readyMeshes.erase(readyMeshes.begin(), readyMeshes.begin() + count);
+
+    std::chrono::duration<float, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    const size_t recentFrames = 240;
+    if (uploadTimes.size() < recentFrames)
+        uploadTimes.push_back(elapsed.count());
+    else
+        uploadTimes[uploadTimesNext] = elapsed.count();
+    uploadTimesNext = (uploadTimesNext + 1) % recentFrames;
+}
+
+void World::update_fill(int missingDelta) {
+    // times how long the view takes to fill up every time it gets holes
+    loadStats.missingChunks += missingDelta;
+    auto now = std::chrono::steady_clock::now();
+
+    if (loadStats.missingChunks > 0 && !filling) {
+        filling = true;
+        fillStart = now;
+    } else if (loadStats.missingChunks == 0 && filling) {
+        filling = false;
+        std::chrono::duration<double, std::milli> elapsed = now - fillStart;
+        loadStats.lastFullViewMs = elapsed.count();
+        if (loadStats.firstFullViewMs == 0)
+            loadStats.firstFullViewMs = elapsed.count();
+    }
+}
+
+void World::unload_chunks(int playerChunkX, int playerChunkZ) {
+    // drops chunks past the unload distance, then the least recently used
+    // ones outside the load distance while over the chunk budget
+    int loadDistance = renderDistance + 1;
+    std::vector<std::pair<int, int>> unload;
+    std::vector<std::pair<long, std::pair<int, int>>> evictable;
+    bool busy = false;
+
+    for (const auto& [pos, chunk] : worldChunks) {
+        int distance = std::max(std::abs(pos.first - playerChunkX), std::abs(pos.second - playerChunkZ));
+        if (distance <= loadDistance) continue;
+
+        // a running job still points to the chunk, try again next frame
+        if (chunk->inFlight || chunk->writing || chunk->readers > 0) {
+            busy = true;
+            continue;
         }
+
+        if (distance > unloadDistance)
+            unload.push_back(pos);
+        else
+            evictable.push_back({ chunk->lastUsed, pos });
+    }
+
+    // chunks inside the load distance are never evicted, so the budget
+    // can't go below what the player currently needs
+    size_t remaining = worldChunks.size() - unload.size();
+    if (remaining > chunkBudget) {
+        size_t count = std::min(remaining - chunkBudget, evictable.size());
+        std::partial_sort(evictable.begin(), evictable.begin() + count, evictable.end());
+        for (size_t i = 0; i < count; ++i)
+            unload.push_back(evictable[i].second);
+    }
+
+    // the chunk destructor releases its GL buffers, there is no save format
+    // so edits in unloaded chunks are regenerated away
+    for (const auto& pos : unload)
+        worldChunks.erase(pos);
+    unloadPending = busy;
+
+    // meshes still waiting for their upload go with their chunk
+    if (!unload.empty()) {
+        readyMeshes.erase(std::remove_if(readyMeshes.begin(), readyMeshes.end(), [this](const ReadyMesh& ready) {
+            return get_chunk(ready.chunkX, ready.chunkZ) != ready.chunk;
+        }), readyMeshes.end());
     }
-    // save the new unordered map as activeChunks
-    activeChunks = std::move(newActiveChunks);
+
+    // trees read the heights of the ring around the loaded chunks
+    generator.forget_heights(playerChunkX, playerChunkZ, unloadDistance + 1);
 }
 
-void World::render(const glm::mat4 &view, const glm::mat4 &projection) {
+void World::render(Shader& boxShader, const glm::mat4 &view, const glm::mat4 &projection) {
     // draw active chunks which are inside the camera frustrum
+    // and weren't hidden behind terrain last frame
+    auto start = std::chrono::steady_clock::now();
     Frustum frustum(projection * view);
+    viewProjection = projection * view;
+    hasViewProjection = true;
+    meshStats = MeshStats();
+    occlusion.set_camera(playerPosition);
+    queriedChunks.clear();
 
     for (const auto& pair : activeChunks) {
         Chunk* chunk = pair.second;
 
         glm::vec3 chunkMin(pair.first.first * CHUNK_SIZE, 0.0f, pair.first.second * CHUNK_SIZE);
         glm::vec3 chunkMax = chunkMin + glm::vec3(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE);
+        if (!frustum.isBoxInside(chunkMin, chunkMax)) continue;
+
+        if (occlusionCulling && chunk->get_quad_count() > 0) {
+            queriedChunks.push_back(pair);
+            glm::vec3 meshMin, meshMax;
+            chunk->get_mesh_bounds(meshMin, meshMax);
+            if (!occlusion.is_visible(pair.first.first, pair.first.second, meshMin, meshMax, frame)) {
+                meshStats.occludedChunks++;
+                meshStats.occludedQuads += chunk->get_quad_count();
+                continue;
+            }
+        }
+
+        chunk->queue_draw(meshArena);
+        meshStats.drawnChunks++;
+        meshStats.faces += chunk->get_face_count();
+        meshStats.quads += chunk->get_quad_count();
+    }
 
-        if (frustum.isBoxInside(chunkMin, chunkMax)) {
-            chunk->draw();
+    meshStats.drawCalls = meshArena.draw_queued(quadIndices.index_type(), batchedDrawing);
+
+    // boxes are tested against the terrain just drawn, the results are used next frame
+    if (!queriedChunks.empty()) {
+        occlusion.begin_queries(boxShader);
+        for (const auto& pair : queriedChunks) {
+            glm::vec3 meshMin, meshMax;
+            pair.second->get_mesh_bounds(meshMin, meshMax);
+            occlusion.query(pair.first.first, pair.first.second, meshMin, meshMax, frame);
         }
+        occlusion.end_queries();
     }
+
+    std::chrono::duration<float, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    meshStats.submitUs = elapsed.count();
+}
+
+void World::set_occlusion_culling(bool enabled) {
+    occlusionCulling = enabled;
 }
 
-void World::load_chunk(int chunkX, int chunkZ) {
+void World::set_batched_drawing(bool enabled) {
+    batchedDrawing = enabled;
+}
+
+void World::set_greedy_meshing(bool enabled) {
+    if (enabled == greedyMeshing) return;
+    greedyMeshing = enabled;
+    meshVersion++;
+
+    // rebuild the meshes in view, the others when they come back into it
+    for (const auto& [pos, chunk] : activeChunks)
+        mark_for_remesh(pos.first, pos.second);
+}
+
+MeshStats World::get_mesh_stats() const {
+    return meshStats;
+}
+
+RemeshStats World::get_remesh_stats() const {
+    return remeshStats;
+}
+
+UploadStats World::get_upload_stats() const {
+    UploadStats stats;
+    stats.pending = int(readyMeshes.size());
+    stats.uploaded = uploadedMeshes;
+    if (!uploadTimes.empty()) {
+        std::vector<float> times = uploadTimes;
+        std::sort(times.begin(), times.end());
+        stats.p50Us = times[times.size() / 2];
+        stats.p99Us = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+    }
+    return stats;
+}
+
+MeshArenaStats World::get_arena_stats() const {
+    return meshArena.get_stats();
+}
+
+void World::set_upload_budget(size_t bytesPerFrame, float usPerFrame) {
+    uploadBudgetBytes = bytesPerFrame;
+    uploadBudgetUs = usPerFrame;
+}
+
+LoadStats World::get_load_stats() const {
+    LoadStats stats = loadStats;
+    stats.queuedLoads = int(loadQueue.size());
+    stats.queuedMeshes = int(meshQueue.size());
+    return stats;
+}
+
+void World::set_chunk_budget(size_t budget) {
+    chunkBudget = budget;
+}
+
+size_t World::get_loaded_chunk_count() const {
+    return worldChunks.size();
+}
+
+void World::set_render_distance(int distance) {
+    // the view is rebuilt on the next update
+    renderDistance = std::max(distance, 1);
+    unloadDistance = renderDistance + 3;
+}
+
+int World::get_render_distance() const {
+    return renderDistance;
+}
+
+void World::on_chunk_enter(ChunkListener listener) {
+    enterListeners.push_back(std::move(listener));
+}
+
+void World::on_chunk_leave(ChunkListener listener) {
+    leaveListeners.push_back(std::move(listener));
+}
+
+Chunk* World::load_chunk(int chunkX, int chunkZ) {
+    // allocated right away, generated once its turn comes in dispatch_queued
     auto chunk = std::make_unique<Chunk>(chunkX, chunkZ);
     Chunk* rawChunk = chunk.get();
+    rawChunk->lastUsed = frame;
     worldChunks[{chunkX, chunkZ}] = std::move(chunk);
+    loadQueue.push_back({ chunkX, chunkZ });
+    return rawChunk;
+}
+
+void World::dispatch_generation(int chunkX, int chunkZ, Chunk* chunk) {
+    // terrain and trees are generated on the worker pool, trees only
+    // depend on the seed so they don't need the neighbors loaded
+    dispatch_job({ chunkX, chunkZ, chunk, CHUNK_DECORATED, {}, { chunk }, {} }, [this](ChunkJob& job) {
+        job.chunk->generate_blocks(generator);
+        job.chunk->generate_trees(generator);
+    });
+}
+
+bool World::dispatch_mesh(int chunkX, int chunkZ, Chunk* chunk) {
+    // queues a meshing job, false if the chunk or a neighbor is busy
+    if (chunk->inFlight || chunk->writing) return false;
+
+    // meshing reads a one block border from all 8 neighbors
+    ChunkNeighborhood neighbors = get_neighborhood(chunkX, chunkZ);
+    std::vector<Chunk*> readChunks;
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            Chunk* neighbor = neighbors.at(dx, dz);
+            if (!neighbor) continue;
+            if (neighbor->state == CHUNK_QUEUED || neighbor->writing) return false;
+            readChunks.push_back(neighbor);
+        }
+    }
+
+    chunk->needsRemesh = false;
+    chunk->meshVersion = meshVersion;
+    dispatch_job({ chunkX, chunkZ, chunk, CHUNK_MESHED, readChunks, {}, {} },
+        [neighbors, greedy = greedyMeshing](ChunkJob& job) {
+            job.mesh = job.chunk->build_mesh(neighbors, greedy);
+        });
+    return true;
+}
+
+void World::dispatch_job(ChunkJob job, std::function<void(ChunkJob&)> work) {
+    // reserves the chunks the job touches and hands it to the pool
+    job.chunk->inFlight = true;
+    jobsInFlight++;
+    for (Chunk* chunk : job.readChunks) chunk->readers++;
+    for (Chunk* chunk : job.writeChunks) chunk->writing = true;
+
+    pool.submit([this, job = std::move(job), work]() mutable {
+        auto start = std::chrono::steady_clock::now();
+        work(job);
+        std::chrono::duration<float, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        job.workUs = elapsed.count();
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        finishedJobs.push_back(std::move(job));
+    });
+}
+
+void World::collect_finished_jobs() {
+    std::vector<ChunkJob> jobs;
+    {
+        std::lock_guard<std::mutex> lock(finishedMutex);
+        jobs.swap(finishedJobs);
+    }
 
-    // get neighbor chunks
-    Chunk* left  = get_chunk(chunkX - 1, chunkZ);
-    Chunk* right = get_chunk(chunkX + 1, chunkZ);
-    Chunk* front = get_chunk(chunkX, chunkZ + 1);
-    Chunk* back  = get_chunk(chunkX, chunkZ - 1);
+    for (ChunkJob& job : jobs) {
+        jobUs = jobUs * 0.9f + job.workUs * 0.1f;
+
+        // release the chunks reserved by the job
+        job.chunk->inFlight = false;
+        jobsInFlight--;
+        for (Chunk* chunk : job.readChunks) chunk->readers--;
+        for (Chunk* chunk : job.writeChunks) chunk->writing = false;
+
+        int chunkX = job.chunkX;
+        int chunkZ = job.chunkZ;
+
+        switch (job.stage) {
+            case CHUNK_DECORATED:
+                job.chunk->state = CHUNK_DECORATED;
+                // neighbors meshed without this chunk have faces and AO computed against air
+                mark_neighbors_for_remesh(chunkX, chunkZ);
+                break;
+            case CHUNK_MESHED: {
+                // uploaded within the frame budget, a newer mesh of the same chunk replaces the waiting one
+                if (job.chunk->state == CHUNK_DECORATED)
+                    job.chunk->state = CHUNK_MESHED;
+
+                auto waiting = std::find_if(readyMeshes.begin(), readyMeshes.end(),
+                                            [&](const ReadyMesh& ready) { return ready.chunk == job.chunk; });
+                if (waiting != readyMeshes.end())
+                    waiting->mesh = std::move(job.mesh);
+                else
+                    readyMeshes.push_back({ chunkX, chunkZ, job.chunk, std::move(job.mesh) });
+
+                // came into view while a mesh with old settings was being built
+                if (job.chunk->meshVersion != meshVersion && !job.chunk->needsRemesh && activeChunks.find(chunkX, chunkZ))
+                    mark_for_remesh(chunkX, chunkZ);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void World::apply_pending_edits() {
+    // retries edits that landed on chunks a job was using
+    std::vector<BlockEdit> edits;
+    edits.swap(pendingEdits);
+
+    for (const BlockEdit& edit : edits)
+        set_block(edit.pos.x, edit.pos.y, edit.pos.z, edit.block);
+}
+
+void World::mark_for_remesh(int chunkX, int chunkZ) {
+    // flags a chunk dirty, a chunk already waiting in the queue
+    // absorbs the request instead of being meshed again
+    Chunk* chunk = get_chunk(chunkX, chunkZ);
+    if (!chunk) return;
 
-    generate_all_trees();
+    // chunks that were never meshed get the change in their first mesh,
+    // unless that mesh is being built right now
+    bool meshing = chunk->state == CHUNK_DECORATED && chunk->inFlight;
+    if (chunk->state < CHUNK_MESHED && !meshing) return;
 
-    // build actual chunk's mesh
-    rawChunk->build_mesh(left, right, front, back);
+    remeshStats.requested++;
+    if (chunk->needsRemesh) {
+        remeshStats.coalesced++;
+        return;
+    }
 
-    // rebuild neighbor chunks' mesh to remove border faces
-    if (left)  left->build_mesh(get_chunk(chunkX - 2, chunkZ), rawChunk, get_chunk(chunkX - 1, chunkZ + 1), get_chunk(chunkX - 1, chunkZ - 1));
-    if (right) right->build_mesh(rawChunk, get_chunk(chunkX + 2, chunkZ), get_chunk(chunkX + 1, chunkZ + 1), get_chunk(chunkX + 1, chunkZ - 1));
-    if (front) front->build_mesh(get_chunk(chunkX - 1, chunkZ + 1), get_chunk(chunkX + 1, chunkZ + 1), get_chunk(chunkX, chunkZ + 2), rawChunk);
-    if (back)  back->build_mesh(get_chunk(chunkX - 1, chunkZ - 1), get_chunk(chunkX + 1, chunkZ - 1), rawChunk, get_chunk(chunkX, chunkZ - 2));
+    chunk->needsRemesh = true;
+    remeshQueue.push_back({ chunkX, chunkZ });
+}
+
+void World::drain_remesh_queue() {
+    // dispatches every dirty chunk once, busy ones stay queued for next frame
+    std::vector<std::pair<int, int>> queue;
+    queue.swap(remeshQueue);
+
+    for (const auto& pos : queue) {
+        Chunk* chunk = get_chunk(pos.first, pos.second);
+        if (!chunk || !chunk->needsRemesh) continue;
+
+        if (dispatch_mesh(pos.first, pos.second, chunk))
+            remeshStats.built++;
+        else
+            remeshQueue.push_back(pos);
+    }
+}
+
+void World::mark_neighbors_for_remesh(int chunkX, int chunkZ) {
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            if (dx != 0 || dz != 0)
+                mark_for_remesh(chunkX + dx, chunkZ + dz);
+        }
+    }
+}
+
+ChunkNeighborhood World::get_neighborhood(int chunkX, int chunkZ) {
+    ChunkNeighborhood neighbors;
+    for (int dx = -1; dx <= 1; ++dx)
+        for (int dz = -1; dz <= 1; ++dz)
+            neighbors.chunks[dx + 1][dz + 1] = get_chunk(chunkX + dx, chunkZ + dz);
+    return neighbors;
 }
 
 
 Chunk* World::get_chunk(int chunkX, int chunkZ) {
-    auto it = worldChunks.find({chunkX, chunkZ});
-    if (it != worldChunks.end()) {
+    std::unique_ptr<Chunk>* chunk = worldChunks.find(chunkX, chunkZ);
+    if (chunk) {
         // found, return chunk
-        return it->second.get();
+        return chunk->get();
     }
     
     return nullptr;
@@ -150,65 +694,59 @@ Chunk* World::get_chunk(int chunkX, int chunkZ) {
 
 Block World::get_block(int worldX, int worldY, int worldZ) const {
     // world coords --> chunk number & chunk coords
-    int chunkX = (worldX >= 0) ? worldX / CHUNK_SIZE : ((worldX + 1) / CHUNK_SIZE) - 1;
-    int chunkZ = (worldZ >= 0) ? worldZ / CHUNK_SIZE : ((worldZ + 1) / CHUNK_SIZE) - 1;
+    int chunkX = ChunkDims::chunk_coord(worldX);
+    int chunkZ = ChunkDims::chunk_coord(worldZ);
 
-    int localX = (worldX % CHUNK_SIZE + CHUNK_SIZE) % CHUNK_SIZE;
-    int localZ = (worldZ % CHUNK_SIZE + CHUNK_SIZE) % CHUNK_SIZE;
+    int localX = ChunkDims::local_coord(worldX);
+    int localZ = ChunkDims::local_coord(worldZ);
 
-    auto it = activeChunks.find({chunkX, chunkZ});
-    if (it != activeChunks.end()) {
+    Chunk* const* chunk = activeChunks.find(chunkX, chunkZ);
+    if (chunk && !(*chunk)->writing) {
         // chunk active, return block in specified chunk coords
-        return it->second->get_block(localX, worldY, localZ);
+        return (*chunk)->get_block(localX, worldY, localZ);
     }
-    // chunk not active (shouldn't happen with current implementation)
+    // chunk not active or still being generated
     return Block(BLOCK_AIR);
 }
 
 void World::set_block(int worldX, int worldY, int worldZ, Block block) {
     // world coords --> chunk number & chunk coords
-    int chunkX = (worldX >= 0) ? worldX / CHUNK_SIZE : ((worldX + 1) / CHUNK_SIZE) - 1;
-    int chunkZ = (worldZ >= 0) ? worldZ / CHUNK_SIZE : ((worldZ + 1) / CHUNK_SIZE) - 1;
+    int chunkX = ChunkDims::chunk_coord(worldX);
+    int chunkZ = ChunkDims::chunk_coord(worldZ);
 
-    int localX = (worldX % CHUNK_SIZE + CHUNK_SIZE) % CHUNK_SIZE;
-    int localZ = (worldZ % CHUNK_SIZE + CHUNK_SIZE) % CHUNK_SIZE;
+    int localX = ChunkDims::local_coord(worldX);
+    int localZ = ChunkDims::local_coord(worldZ);
 
     Chunk* chunk = get_chunk(chunkX, chunkZ);
     if (chunk) {
+        if (chunk->state == CHUNK_QUEUED || chunk->writing || chunk->readers > 0) {
+            // a job is using the chunk, retry on next update
+            pendingEdits.push_back({ glm::ivec3(worldX, worldY, worldZ), block });
+            return;
+        }
+
         // chunk active, set block in specific chunk coords
         chunk->set_block(localX, worldY, localZ, block);
 
-        Chunk* left  = get_chunk(chunkX - 1, chunkZ);
-        Chunk* right = get_chunk(chunkX + 1, chunkZ);
-        Chunk* front = get_chunk(chunkX, chunkZ + 1);
-        Chunk* back  = get_chunk(chunkX, chunkZ - 1);
+        mark_for_remesh(chunkX, chunkZ);
 
-        chunk->build_mesh(left, right, front, back);
-
-        // block placed in a chunk border, rebuild neighbor
-        if (localX == 0 && left)   left->build_mesh(get_chunk(chunkX - 2, chunkZ), chunk, get_chunk(chunkX - 1, chunkZ + 1), get_chunk(chunkX - 1, chunkZ - 1));
-        if (localX == CHUNK_SIZE - 1 && right) right->build_mesh(chunk, get_chunk(chunkX + 2, chunkZ), get_chunk(chunkX + 1, chunkZ + 1), get_chunk(chunkX + 1, chunkZ - 1));
-        if (localZ == 0 && back)   back->build_mesh(get_chunk(chunkX - 1, chunkZ - 1), get_chunk(chunkX + 1, chunkZ - 1), chunk, get_chunk(chunkX, chunkZ - 2));
-        if (localZ == CHUNK_SIZE - 1 && front) front->build_mesh(get_chunk(chunkX - 1, chunkZ + 1), get_chunk(chunkX + 1, chunkZ + 1), get_chunk(chunkX, chunkZ + 2), chunk);
-    }
-}
-
-void World::generate_all_trees() {
-    for (auto& [pos, chunk] : worldChunks) {
-        int x = pos.first;
-        int z = pos.second;
-
-        Chunk* left  = get_chunk(x - 1, z);
-        Chunk* right = get_chunk(x + 1, z);
-        Chunk* back  = get_chunk(x, z - 1);
-        Chunk* front = get_chunk(x, z + 1);
-
-        chunk->generate_trees(left, right, front, back);
+        // block placed in a chunk border, remesh neighbors (diagonal ones for corner AO)
+        int borderX = localX == 0 ? -1 : (localX == CHUNK_SIZE - 1 ? 1 : 0);
+        int borderZ = localZ == 0 ? -1 : (localZ == CHUNK_SIZE - 1 ? 1 : 0);
+        if (borderX != 0)                 mark_for_remesh(chunkX + borderX, chunkZ);
+        if (borderZ != 0)                 mark_for_remesh(chunkX, chunkZ + borderZ);
+        if (borderX != 0 && borderZ != 0) mark_for_remesh(chunkX + borderX, chunkZ + borderZ);
     }
 }
 
 void World::free() {
+    // wait for running jobs before releasing the chunks they point to
+    pool.stop();
+    readyMeshes.clear();
     activeChunks.clear();
     worldChunks.clear();
+    occlusion.free();
+    meshArena.free();
+    quadIndices.free();
     freed = true;
-}
\ No newline at end of file
+}
@@ -0,0 +1,105 @@
+#include "worldGenerator.hpp"
+
+#include <cstdlib>
+
+WorldGenerator::WorldGenerator(uint32_t seed) : seed(seed), terrainNoise((int)seed, 0.01f) {
+    treeNoise.SetNoiseType(FastNoiseLite::NoiseType_OpenSimplex2);
+    treeNoise.SetFrequency(4.0f);
+    treeNoise.SetSeed((int)(seed + 5000));
+}
+
+uint32_t WorldGenerator::get_seed() const {
+    return seed;
+}
+
+float WorldGenerator::tree_chance(int worldX, int worldZ) const {
+    return treeNoise.GetNoise((float)worldX, (float)worldZ);
+}
+
+void WorldGenerator::compute_heights(int chunkX, int chunkZ, ColumnHeights& heights) const {
+    // 4 octaves of terrain noise over every column of the chunk, one batch per octave
+    const int COLUMNS = CHUNK_SIZE * CHUNK_SIZE;
+    const float baseFrequency = 0.5f;
+    float baseX[COLUMNS], baseZ[COLUMNS];
+    float x[COLUMNS], z[COLUMNS], noise[COLUMNS];
+    float total[COLUMNS] = {};
+
+    for (int localZ = 0; localZ < CHUNK_SIZE; ++localZ) {
+        for (int localX = 0; localX < CHUNK_SIZE; ++localX) {
+            int column = localX + localZ * CHUNK_SIZE;
+            baseX[column] = (chunkX * CHUNK_SIZE + localX) * baseFrequency;
+            baseZ[column] = (chunkZ * CHUNK_SIZE + localZ) * baseFrequency;
+        }
+    }
+
+    float amplitude = 1.0f;
+    float frequency = 1.0f;
+    float maxValue = 0.0f;
+
+    for (int i = 0; i < 4; ++i) {
+        for (int column = 0; column < COLUMNS; ++column) {
+            x[column] = baseX[column] * frequency;
+            z[column] = baseZ[column] * frequency;
+        }
+        terrainNoise.evaluate(x, z, noise, COLUMNS);
+        for (int column = 0; column < COLUMNS; ++column)
+            total[column] += noise[column] * amplitude;
+
+        maxValue += amplitude;
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+
+    // y of the surface block of each column
+    for (int column = 0; column < COLUMNS; ++column) {
+        float heightNoise = total[column] / maxValue;
+        heights.height[column] = (int16_t)((heightNoise + 1.0f) * 0.5f * (CHUNK_HEIGHT - 1));
+    }
+}
+
+std::shared_ptr<const ColumnHeights> WorldGenerator::get_heights(int chunkX, int chunkZ) {
+    {
+        std::lock_guard<std::mutex> lock(heightsMutex);
+        const std::shared_ptr<const ColumnHeights>* cached = heights.find(chunkX, chunkZ);
+        if (cached)
+            return *cached;
+    }
+
+    // computed without the lock, two threads may both do it but only one is kept
+    auto computed = std::make_shared<ColumnHeights>();
+    compute_heights(chunkX, chunkZ, *computed);
+
+    std::lock_guard<std::mutex> lock(heightsMutex);
+    std::shared_ptr<const ColumnHeights>& stored = heights[{chunkX, chunkZ}];
+    if (!stored)
+        stored = std::move(computed);
+    return stored;
+}
+
+int WorldGenerator::get_height(int worldX, int worldZ) {
+    // world coords --> chunk number & chunk coords
+    int chunkX = ChunkDims::chunk_coord(worldX);
+    int chunkZ = ChunkDims::chunk_coord(worldZ);
+
+    int localX = ChunkDims::local_coord(worldX);
+    int localZ = ChunkDims::local_coord(worldZ);
+
+    return get_heights(chunkX, chunkZ)->at(localX, localZ);
+}
+
+void WorldGenerator::forget_heights(int chunkX, int chunkZ, int distance) {
+    std::lock_guard<std::mutex> lock(heightsMutex);
+    // collected first, erasing moves entries around
+    std::vector<std::pair<int, int>> forget;
+    for (const auto& [pos, tile] : heights) {
+        if (std::abs(pos.first - chunkX) > distance || std::abs(pos.second - chunkZ) > distance)
+            forget.push_back(pos);
+    }
+    for (const auto& pos : forget)
+        heights.erase(pos);
+}
+
+size_t WorldGenerator::cached_height_chunks() {
+    std::lock_guard<std::mutex> lock(heightsMutex);
+    return heights.size();
+}